@@ -23,7 +23,9 @@
 #include <boost/log/trivial.hpp>
 
 #include <nil/proof-generator/arithmetization_params.hpp>
+#include <nil/proof-generator/io_formats.hpp>
 #include <nil/proof-generator/meta_utils.hpp>
+#include <nil/proof-generator/thread_placement.hpp>
 
 namespace nil {
     namespace proof_generator {
@@ -36,6 +38,12 @@ namespace nil {
         struct ProverOptions {
             std::string stage = "all";
             boost::filesystem::path proof_file_path = "proof.bin";
+            // Non-negative means the proof goes to this inherited descriptor instead of proof_file_path.
+            int proof_fd = -1;
+            ProofFormat proof_format = ProofFormat::HEX;
+            bool no_json = false;
+            bool async_write = false;
+            int compression_level = 0;
             boost::filesystem::path json_file_path = "proof.json";
             boost::filesystem::path preprocessed_common_data_path = "preprocessed_common_data.dat";
             boost::filesystem::path preprocessed_public_data_path = "preprocessed_data.dat";
@@ -43,20 +51,53 @@ namespace nil {
             boost::filesystem::path circuit_file_path;
             boost::filesystem::path assignment_table_file_path;
             boost::filesystem::path assignment_description_file_path;
+            boost::filesystem::path indexed_assignment_table_file_path = "assignment.itbl";
             std::vector<boost::filesystem::path> input_challenge_files;
+            boost::filesystem::path packed_input_challenges_file;
+            std::size_t io_threads = 16;
+            ThreadPlacementOptions thread_placement;
+            // 0 means no limit.
+            std::size_t memory_limit = 0;
+            // Empty means the system temp directory.
+            boost::filesystem::path scratch_dir;
             boost::filesystem::path aggregated_challenge_file = "aggregated_challenge.dat";
+            boost::filesystem::path socket_path = "proof-producer.sock";
+            boost::filesystem::path jobs_manifest_path;
+            boost::filesystem::path preprocess_cache_path;
+            boost::filesystem::path metrics_file_path;
+            boost::filesystem::path trace_file_path;
+            boost::filesystem::path counters_file_path;
+            // Empty means the built-in defaults.
+            boost::filesystem::path cost_model_file_path;
+            // latency, memory or proof-size, empty for the parameters as given.
+            std::string auto_params;
+            // 0 means the security of the given parameters.
+            std::size_t security_bits = 0;
+            // Empty means the standard output.
+            boost::filesystem::path estimate_file_path;
+            std::uintmax_t preprocess_cache_max_size = std::uintmax_t(64) << 30;
             boost::log::trivial::severity_level log_level = boost::log::trivial::severity_level::info;
             CurvesVariant elliptic_curve_type = type_identity<nil::crypto3::algebra::curves::pallas>{};
             HashesVariant hash_type = type_identity<nil::crypto3::hashes::keccak_1600<256>>{};
 
             std::size_t lambda = 9;
-            std::size_t grind = 69;
+            // Proof of work bits, 0 for no grinding.
+            std::size_t grind = 0;
             std::size_t expand_factor = 2;
             std::size_t max_quotient_chunks = 0;
         };
 
+        // Proof of work is an unsigned 32-bit nonce.
+        constexpr std::size_t max_grind_bits = 32;
+
+        // Higher zstd levels take far longer to compress for little gain on marshalled field elements.
+        constexpr int max_compression_level = 19;
+
         std::optional<ProverOptions> parse_args(int argc, char* argv[]);
 
+        // Name of the hash type as given with --hash-type.
+        std::string hash_type_name(const HashesVariant& hash_type);
+
     } // namespace proof_generator
 } // namespace nil
 
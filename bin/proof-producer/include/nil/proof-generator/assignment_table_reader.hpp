@@ -0,0 +1,328 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_ASSIGNMENT_TABLE_READER_HPP
+#define PROOF_GENERATOR_ASSIGNMENT_TABLE_READER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+#include <nil/marshalling/field_type.hpp>
+#include <nil/marshalling/status_type.hpp>
+#include <nil/marshalling/types/integral.hpp>
+
+#include <nil/crypto3/marshalling/algebra/types/field_element.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/assignment.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/table_description.hpp>
+
+#include <nil/proof-generator/counters.hpp>
+#include <nil/proof-generator/metrics.hpp>
+
+namespace nil {
+    namespace proof_generator {
+        namespace detail {
+
+            // Sequential marshalling reader over a byte range.
+            class ByteRangeReader {
+            public:
+                ByteRangeReader(const std::uint8_t* data, std::size_t size)
+                    : position_(data)
+                    , end_(data + size) {
+                }
+
+                template<typename MarshallingType>
+                bool read(MarshallingType& value) {
+                    auto iter = position_;
+                    auto status = value.read(iter, remaining());
+                    if (status != nil::marshalling::status_type::success) {
+                        return false;
+                    }
+                    position_ = iter;
+                    return true;
+                }
+
+                bool skip(std::size_t size) {
+                    if (size > remaining()) {
+                        return false;
+                    }
+                    position_ += size;
+                    return true;
+                }
+
+                std::size_t remaining() const {
+                    return static_cast<std::size_t>(end_ - position_);
+                }
+
+            private:
+                const std::uint8_t* position_;
+                const std::uint8_t* end_;
+            };
+
+            // Sequential marshalling reader over a pipe or a file, decoding starts as soon as the first bytes
+            // arrive instead of after the whole input is there.
+            class FdByteReader {
+            public:
+                static constexpr std::size_t buffer_size = 1 << 20;
+
+                FdByteReader(int fd, std::string path)
+                    : fd_(fd)
+                    , path_(std::move(path))
+                    , buffer_(buffer_size) {
+                }
+
+                template<typename MarshallingType>
+                bool read(MarshallingType& value) {
+                    std::size_t size = value.length();
+                    if (!fill(size)) {
+                        return false;
+                    }
+                    const std::uint8_t* iter = buffer_.data() + begin_;
+                    if (value.read(iter, size) != nil::marshalling::status_type::success) {
+                        return false;
+                    }
+                    begin_ += size;
+                    return true;
+                }
+
+                bool skip(std::size_t size) {
+                    while (size > 0) {
+                        if (!fill(1)) {
+                            return false;
+                        }
+                        std::size_t amount = std::min(size, end_ - begin_);
+                        begin_ += amount;
+                        size -= amount;
+                    }
+                    return true;
+                }
+
+                // Points data to the next size bytes without consuming them.
+                bool peek(std::size_t size, const std::uint8_t*& data) {
+                    if (!fill(size)) {
+                        return false;
+                    }
+                    data = buffer_.data() + begin_;
+                    return true;
+                }
+
+                // Everything up to the end of the input, for the formats that can't be decoded sequentially.
+                std::optional<std::vector<std::uint8_t>> read_to_end() {
+                    std::vector<std::uint8_t> result(buffer_.begin() + begin_, buffer_.begin() + end_);
+                    begin_ = end_ = 0;
+                    while (fill(1)) {
+                        result.insert(result.end(), buffer_.begin(), buffer_.begin() + end_);
+                        begin_ = end_ = 0;
+                    }
+                    if (failed_) {
+                        return std::nullopt;
+                    }
+                    return result;
+                }
+
+            private:
+                // Makes at least size bytes available, false on the end of the input or an error.
+                bool fill(std::size_t size) {
+                    if (end_ - begin_ >= size) {
+                        return true;
+                    }
+                    std::copy(buffer_.begin() + begin_, buffer_.begin() + end_, buffer_.begin());
+                    end_ -= begin_;
+                    begin_ = 0;
+                    if (buffer_.size() < size) {
+                        buffer_.resize(size);
+                    }
+                    while (end_ < size) {
+                        ssize_t amount = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+                        if (amount < 0 && errno == EINTR) {
+                            continue;
+                        }
+                        if (amount < 0) {
+                            BOOST_LOG_TRIVIAL(error) << "Error occurred during reading file " << path_ << ": "
+                                                     << std::strerror(errno);
+                            failed_ = true;
+                            return false;
+                        }
+                        if (amount == 0) {
+                            return false;
+                        }
+                        end_ += static_cast<std::size_t>(amount);
+                        Metrics::instance().add_bytes_read(static_cast<std::size_t>(amount));
+                    }
+                    return true;
+                }
+
+                int fd_;
+                std::string path_;
+                std::vector<std::uint8_t> buffer_;
+                std::size_t begin_ = 0;
+                std::size_t end_ = 0;
+                bool failed_ = false;
+            };
+
+        } // namespace detail
+
+        // Sections of the assignment table to decode, the others are skipped and left empty in the table.
+        struct TableSections {
+            bool witnesses = true;
+            bool public_inputs = true;
+            bool constants = true;
+            bool selectors = true;
+        };
+
+        inline constexpr TableSections all_table_sections {true, true, true, true};
+        // The public preprocessor doesn't need the witnesses.
+        inline constexpr TableSections public_table_sections {false, true, true, true};
+        // Constants and selectors are in the preprocessed data already when proving.
+        inline constexpr TableSections proving_table_sections {true, true, false, false};
+
+        // Decodes an assignment table written by crypto3 plonk_assignment_table marshalling straight into the
+        // table columns, without building the marshalled representation of the whole table first.
+        // Layout: witness, public input, constant and selector amounts, usable rows, rows amount, then four
+        // length-prefixed sections with the columns of each kind, every column padded to rows amount.
+        template<typename Endianness, typename FieldType, typename Column>
+        class AssignmentTableReader {
+        public:
+            using AssignmentTable = nil::crypto3::zk::snark::plonk_table<FieldType, Column>;
+            using TableDescription = nil::crypto3::zk::snark::plonk_table_description<FieldType>;
+            using TTypeBase = nil::marshalling::field_type<Endianness>;
+            using SizeMarshalling = nil::marshalling::types::integral<TTypeBase, std::size_t>;
+            using ElementMarshalling =
+                nil::crypto3::marshalling::types::field_element<TTypeBase, typename FieldType::value_type>;
+
+            // Field elements have a fixed marshalled size, so skipped sections are stepped over without decoding.
+            static std::size_t element_size() {
+                return ElementMarshalling().length();
+            }
+
+            // Amount of bytes of the sections that reading with the given sections skips.
+            static std::size_t skipped_size(const TableDescription& description, const TableSections& sections) {
+                std::size_t columns_amount = (sections.witnesses ? 0 : description.witness_columns) +
+                                             (sections.public_inputs ? 0 : description.public_input_columns) +
+                                             (sections.constants ? 0 : description.constant_columns) +
+                                             (sections.selectors ? 0 : description.selector_columns);
+                return columns_amount * description.rows_amount * element_size();
+            }
+
+            static std::optional<std::pair<TableDescription, AssignmentTable>> read(
+                const std::uint8_t* data,
+                std::size_t size,
+                const TableSections& sections = all_table_sections
+            ) {
+                detail::ByteRangeReader reader(data, size);
+                return read(reader, sections);
+            }
+
+            // Reader is detail::ByteRangeReader or detail::FdByteReader.
+            template<typename Reader>
+            static std::optional<std::pair<TableDescription, AssignmentTable>> read(
+                Reader& reader,
+                const TableSections& sections = all_table_sections
+            ) {
+                std::size_t header[6];
+                for (auto& value : header) {
+                    SizeMarshalling marshalled_value;
+                    if (!reader.read(marshalled_value)) {
+                        BOOST_LOG_TRIVIAL(error) << "Assignment table header is truncated";
+                        return std::nullopt;
+                    }
+                    value = marshalled_value.value();
+                }
+                TableDescription description(header[0], header[1], header[2], header[3], header[4], header[5]);
+
+                std::vector<Column> witnesses, public_inputs, constants, selectors;
+                const std::size_t rows = description.rows_amount;
+                const std::size_t public_input_columns = description.public_input_columns;
+                if (!read_columns(reader, description.witness_columns, rows, sections.witnesses, witnesses) ||
+                    !read_columns(reader, public_input_columns, rows, sections.public_inputs, public_inputs) ||
+                    !read_columns(reader, description.constant_columns, rows, sections.constants, constants) ||
+                    !read_columns(reader, description.selector_columns, rows, sections.selectors, selectors)) {
+                    return std::nullopt;
+                }
+
+                return std::make_pair(
+                    description,
+                    AssignmentTable(
+                        typename AssignmentTable::private_table_type(std::move(witnesses)),
+                        typename AssignmentTable::public_table_type(
+                            std::move(public_inputs),
+                            std::move(constants),
+                            std::move(selectors)
+                        )
+                    )
+                );
+            }
+
+        private:
+            template<typename Reader>
+            static bool read_columns(
+                Reader& reader,
+                std::size_t columns_amount,
+                std::size_t rows_amount,
+                bool decode,
+                std::vector<Column>& columns
+            ) {
+                SizeMarshalling marshalled_size;
+                if (!reader.read(marshalled_size)) {
+                    BOOST_LOG_TRIVIAL(error) << "Assignment table section size is truncated";
+                    return false;
+                }
+                if (marshalled_size.value() != columns_amount * rows_amount) {
+                    BOOST_LOG_TRIVIAL(error) << "Assignment table section holds " << marshalled_size.value()
+                                             << " values, expected " << columns_amount << " columns of "
+                                             << rows_amount << " rows";
+                    return false;
+                }
+
+                if (!decode) {
+                    if (!reader.skip(columns_amount * rows_amount * element_size())) {
+                        BOOST_LOG_TRIVIAL(error) << "Assignment table section is truncated";
+                        return false;
+                    }
+                    return true;
+                }
+
+                columns.resize(columns_amount);
+                ElementMarshalling marshalled_element;
+                for (auto& column : columns) {
+                    column.resize(rows_amount);
+                    for (auto& cell : column) {
+                        if (!reader.read(marshalled_element)) {
+                            BOOST_LOG_TRIVIAL(error) << "Assignment table column is truncated";
+                            return false;
+                        }
+                        cell = marshalled_element.value();
+                    }
+                }
+                PROOF_GENERATOR_COUNT(COLUMNS_DECODED, columns_amount);
+                PROOF_GENERATOR_COUNT(CELLS_DECODED, columns_amount * rows_amount);
+                return true;
+            }
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_ASSIGNMENT_TABLE_READER_HPP
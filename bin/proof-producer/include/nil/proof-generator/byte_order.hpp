@@ -0,0 +1,46 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_BYTE_ORDER_HPP
+#define PROOF_GENERATOR_BYTE_ORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Headers of the producer's own file formats are little-endian.
+namespace nil {
+    namespace proof_generator {
+        namespace detail {
+            template<typename T>
+            void store_le(std::uint8_t* out, T value) {
+                for (std::size_t i = 0; i < sizeof(T); ++i) {
+                    out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+                }
+            }
+
+            template<typename T>
+            T load_le(const std::uint8_t* in) {
+                T value = 0;
+                for (std::size_t i = 0; i < sizeof(T); ++i) {
+                    value |= static_cast<T>(in[i]) << (8 * i);
+                }
+                return value;
+            }
+        } // namespace detail
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_BYTE_ORDER_HPP
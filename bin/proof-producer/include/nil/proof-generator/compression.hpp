@@ -0,0 +1,178 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_COMPRESSION_HPP
+#define PROOF_GENERATOR_COMPRESSION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <zstd.h>
+
+#include <boost/log/trivial.hpp>
+
+#include <nil/proof-generator/byte_order.hpp>
+#include <nil/proof-generator/counters.hpp>
+#include <nil/proof-generator/parallel.hpp>
+
+// Chunked zstd container for the large marshalled files. Chunks are compressed independently, so both
+// directions run on all cores. Layout, integers little-endian:
+//     magic "NILZ", u32 version, u64 chunk size, u64 uncompressed size, u64 chunks amount,
+//     u64 compressed size of every chunk, then the compressed chunks.
+namespace nil {
+    namespace proof_generator {
+        namespace compression {
+            constexpr std::uint8_t magic[4] = {'N', 'I', 'L', 'Z'};
+            constexpr std::uint32_t version = 1;
+            constexpr std::size_t header_size = 4 + 4 + 3 * 8;
+            constexpr std::size_t default_chunk_size = std::size_t(4) << 20;
+            constexpr int default_level = 3;
+
+            namespace detail {
+                using nil::proof_generator::detail::load_le;
+                using nil::proof_generator::detail::store_le;
+
+                inline std::size_t default_threads() {
+                    return available_cpus();
+                }
+            } // namespace detail
+
+            inline bool is_compressed(const std::uint8_t* data, std::size_t size) {
+                return size >= header_size && std::memcmp(data, magic, sizeof(magic)) == 0;
+            }
+
+            inline std::optional<std::vector<std::uint8_t>> compress(
+                const std::uint8_t* data,
+                std::size_t size,
+                int level = default_level,
+                std::size_t chunk_size = default_chunk_size,
+                std::size_t threads = detail::default_threads()
+            ) {
+                PROOF_GENERATOR_COUNT(BYTES_COMPRESSED, size);
+                const std::size_t chunks_amount = (size + chunk_size - 1) / chunk_size;
+                std::vector<std::vector<std::uint8_t>> chunks(chunks_amount);
+                std::atomic<bool> failed {false};
+                run_in_parallel(chunks_amount, threads, [&](std::size_t i) {
+                    std::size_t offset = i * chunk_size;
+                    std::size_t amount = std::min(chunk_size, size - offset);
+                    std::vector<std::uint8_t>& chunk = chunks[i];
+                    chunk.resize(ZSTD_compressBound(amount));
+                    std::size_t compressed = ZSTD_compress(chunk.data(), chunk.size(), data + offset, amount, level);
+                    if (ZSTD_isError(compressed)) {
+                        BOOST_LOG_TRIVIAL(error) << "Compression failed: " << ZSTD_getErrorName(compressed);
+                        failed = true;
+                        return;
+                    }
+                    chunk.resize(compressed);
+                });
+                if (failed) {
+                    return std::nullopt;
+                }
+
+                std::size_t total_size = header_size + 8 * chunks_amount;
+                for (const auto& chunk : chunks) {
+                    total_size += chunk.size();
+                }
+                std::vector<std::uint8_t> result(total_size);
+                std::uint8_t* out = result.data();
+                std::memcpy(out, magic, sizeof(magic));
+                detail::store_le<std::uint32_t>(out + 4, version);
+                detail::store_le<std::uint64_t>(out + 8, chunk_size);
+                detail::store_le<std::uint64_t>(out + 16, size);
+                detail::store_le<std::uint64_t>(out + 24, chunks_amount);
+                out += header_size;
+                for (const auto& chunk : chunks) {
+                    detail::store_le<std::uint64_t>(out, chunk.size());
+                    out += 8;
+                }
+                for (auto& chunk : chunks) {
+                    std::memcpy(out, chunk.data(), chunk.size());
+                    out += chunk.size();
+                    std::vector<std::uint8_t>().swap(chunk);
+                }
+                return result;
+            }
+
+            inline std::optional<std::vector<std::uint8_t>> decompress(
+                const std::uint8_t* data,
+                std::size_t size,
+                std::size_t threads = detail::default_threads()
+            ) {
+                if (!is_compressed(data, size)) {
+                    BOOST_LOG_TRIVIAL(error) << "Data is not compressed";
+                    return std::nullopt;
+                }
+                if (detail::load_le<std::uint32_t>(data + 4) != version) {
+                    BOOST_LOG_TRIVIAL(error) << "Unsupported compressed data version "
+                                             << detail::load_le<std::uint32_t>(data + 4);
+                    return std::nullopt;
+                }
+                const std::uint64_t chunk_size = detail::load_le<std::uint64_t>(data + 8);
+                const std::uint64_t uncompressed_size = detail::load_le<std::uint64_t>(data + 16);
+                const std::uint64_t chunks_amount = detail::load_le<std::uint64_t>(data + 24);
+                if (chunk_size == 0 || chunks_amount != (uncompressed_size + chunk_size - 1) / chunk_size ||
+                    chunks_amount > (size - header_size) / 8) {
+                    BOOST_LOG_TRIVIAL(error) << "Compressed data header is corrupted";
+                    return std::nullopt;
+                }
+
+                std::vector<std::size_t> offsets(chunks_amount + 1);
+                offsets[0] = header_size + 8 * chunks_amount;
+                for (std::size_t i = 0; i < chunks_amount; ++i) {
+                    std::uint64_t chunk_compressed_size = detail::load_le<std::uint64_t>(data + header_size + 8 * i);
+                    if (chunk_compressed_size > size - offsets[i]) {
+                        BOOST_LOG_TRIVIAL(error) << "Compressed data is truncated";
+                        return std::nullopt;
+                    }
+                    offsets[i + 1] = offsets[i] + chunk_compressed_size;
+                }
+
+                std::vector<std::uint8_t> result(uncompressed_size);
+                std::atomic<bool> failed {false};
+                run_in_parallel(chunks_amount, threads, [&](std::size_t i) {
+                    std::size_t offset = i * chunk_size;
+                    std::size_t amount = std::min<std::uint64_t>(chunk_size, uncompressed_size - offset);
+                    std::size_t decompressed = ZSTD_decompress(
+                        result.data() + offset,
+                        amount,
+                        data + offsets[i],
+                        offsets[i + 1] - offsets[i]
+                    );
+                    if (ZSTD_isError(decompressed) || decompressed != amount) {
+                        BOOST_LOG_TRIVIAL(error) << "Decompression of chunk " << i << " failed"
+                                                 << (ZSTD_isError(decompressed)
+                                                         ? std::string(": ") + ZSTD_getErrorName(decompressed)
+                                                         : std::string());
+                        failed = true;
+                    }
+                });
+                if (failed) {
+                    return std::nullopt;
+                }
+                PROOF_GENERATOR_COUNT(BYTES_DECOMPRESSED, uncompressed_size);
+                return result;
+            }
+
+        } // namespace compression
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_COMPRESSION_HPP
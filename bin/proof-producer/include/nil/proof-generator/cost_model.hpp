@@ -0,0 +1,383 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_COST_MODEL_HPP
+#define PROOF_GENERATOR_COST_MODEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+
+namespace nil {
+    namespace proof_generator {
+
+        // What the costs of the stages depend on, known from the circuit and the table description alone.
+        struct CircuitShape {
+            std::size_t rows_amount = 0;
+            std::size_t witness_columns = 0;
+            std::size_t public_input_columns = 0;
+            std::size_t constant_columns = 0;
+            std::size_t selector_columns = 0;
+            std::size_t gates_amount = 0;
+            std::size_t constraints_amount = 0;
+            std::size_t max_gate_degree = 0;
+            std::size_t lookup_gates_amount = 0;
+            // Marshalled sizes of a field element and of a commitment digest.
+            std::size_t element_size = 32;
+            std::size_t digest_size = 32;
+        };
+
+        struct ProofParameters {
+            std::size_t lambda = 0;
+            std::size_t expand_factor = 0;
+            std::size_t max_quotient_chunks = 0;
+            std::size_t grind = 0;
+        };
+
+        // Conjectured soundness of the FRI queries: every query over a code of rate 2^-expand_factor gives
+        // expand_factor bits, grinding adds its bits on top.
+        inline std::size_t conjectured_security_bits(const ProofParameters& parameters) {
+            return parameters.lambda * parameters.expand_factor + parameters.grind;
+        }
+
+        enum class TuningObjective {
+            LATENCY,
+            MEMORY,
+            PROOF_SIZE
+        };
+
+        inline std::optional<TuningObjective> tuning_objective_from_string(const std::string& objective) {
+            if (objective == "latency") {
+                return TuningObjective::LATENCY;
+            }
+            if (objective == "memory") {
+                return TuningObjective::MEMORY;
+            }
+            if (objective == "proof-size") {
+                return TuningObjective::PROOF_SIZE;
+            }
+            return std::nullopt;
+        }
+
+        // Polynomial counts of the placeholder argument for a shape and parameters. Columns taking part in copy
+        // constraints are bounded by all of witnesses, public inputs and constants. Without a chunk limit the
+        // permutation product is a single polynomial of degree of that bound, with the limit it is split into
+        // parts of degree max_quotient_chunks - 1.
+        struct ArgumentSize {
+            std::size_t permuted_columns;
+            std::size_t permutation_polynomials;
+            std::size_t lookup_polynomials;
+            std::size_t quotient_chunks;
+            std::size_t rows_log;
+            std::size_t extended_rows_log;
+
+            ArgumentSize(const CircuitShape& shape, const ProofParameters& parameters) {
+                permuted_columns = shape.witness_columns + shape.public_input_columns + shape.constant_columns;
+                if (parameters.max_quotient_chunks == 0) {
+                    permutation_polynomials = 1;
+                    quotient_chunks = std::max(shape.max_gate_degree, permuted_columns + 1);
+                } else {
+                    const std::size_t part_degree = std::max<std::size_t>(parameters.max_quotient_chunks, 2) - 1;
+                    permutation_polynomials = (permuted_columns + part_degree - 1) / part_degree;
+                    quotient_chunks = std::max(shape.max_gate_degree, parameters.max_quotient_chunks);
+                }
+                // A sorted polynomial per lookup gate and their common product.
+                lookup_polynomials = shape.lookup_gates_amount == 0 ? 0 : shape.lookup_gates_amount + 1;
+                rows_log = 0;
+                while ((std::size_t(1) << rows_log) < shape.rows_amount) {
+                    ++rows_log;
+                }
+                extended_rows_log = rows_log + parameters.expand_factor;
+            }
+        };
+
+        // Every predicted quantity is intercept + slope * feature, with the feature computed from the shape and
+        // the parameters. The defaults are rough guesses, not fitted to any machine or hash: the model is meant to
+        // be fitted on the target machine for the hash in use from the benchmark output with tests/fit_cost_model.sh
+        // and passed with --cost-model. Estimates relying on any default are reported as uncalibrated.
+        class CostModel {
+        public:
+            struct Term {
+                double intercept;
+                double slope;
+            };
+
+            enum class Quantity : std::size_t {
+                PREPROCESS_CPU_SECONDS,
+                PROVE_CPU_SECONDS,
+                VERIFY_CPU_SECONDS,
+                PREPROCESS_PEAK_RSS_BYTES,
+                PROVE_PEAK_RSS_BYTES,
+                VERIFY_PEAK_RSS_BYTES,
+                PREPROCESSED_DATA_BYTES,
+                PROOF_BYTES,
+                QUANTITIES_AMOUNT
+            };
+
+            // Search range of the tuning, quotient chunks 0 (no limit) are tried as well.
+            static constexpr std::size_t max_tuned_expand_factor = 5;
+            static constexpr std::size_t max_tuned_quotient_chunks = 32;
+
+            static constexpr std::size_t quantities_amount = static_cast<std::size_t>(Quantity::QUANTITIES_AMOUNT);
+
+            static constexpr const char* quantity_names[quantities_amount] = {
+                "preprocess_cpu_seconds",
+                "prove_cpu_seconds",
+                "verify_cpu_seconds",
+                "preprocess_peak_rss_bytes",
+                "prove_peak_rss_bytes",
+                "verify_peak_rss_bytes",
+                "preprocessed_data_bytes",
+                "proof_bytes",
+            };
+
+            using Features = std::array<double, quantities_amount>;
+
+            static CostModel default_model() {
+                CostModel model;
+                model.fitted_.fill(false);
+                model.terms_ = {{
+                    {0.05, 2e-8},      // preprocess_cpu_seconds per butterfly over the preprocessed polynomials
+                    {0.1, 5e-8},       // prove_cpu_seconds per butterfly and constraint evaluation
+                    {0.05, 2e-8},      // verify_cpu_seconds per byte of the query openings
+                    {64e6, 2.0},       // preprocess_peak_rss_bytes per byte of extended preprocessed polynomials
+                    {64e6, 2.0},       // prove_peak_rss_bytes per byte of all the extended polynomials
+                    {32e6, 4.0},       // verify_peak_rss_bytes per byte of the query openings
+                    {1e3, 1.0},        // preprocessed_data_bytes per byte of extended preprocessed polynomials
+                    {1e3, 2.0},        // proof_bytes per byte of the query openings, hex encoded
+                }};
+                return model;
+            }
+
+            // The defaults when path is empty.
+            static std::optional<CostModel> load(const boost::filesystem::path& path, const std::string& hash_type) {
+                if (path.empty()) {
+                    BOOST_LOG_TRIVIAL(warning) << "No --cost-model given, the built-in uncalibrated one is used";
+                    return default_model();
+                }
+                return read(path, hash_type);
+            }
+
+            // Lines "<quantity> <intercept> <slope>", '#' starts a comment. Quantities not listed keep the defaults.
+            // A "hash_type <name>" line names the hash the model was fitted for, it must be the one in use.
+            static std::optional<CostModel> read(const boost::filesystem::path& path, const std::string& hash_type) {
+                std::ifstream file(path.string());
+                if (!file) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to open cost model " << path;
+                    return std::nullopt;
+                }
+                CostModel model = default_model();
+                std::string line;
+                for (std::size_t line_number = 1; std::getline(file, line); ++line_number) {
+                    line = line.substr(0, line.find('#'));
+                    std::istringstream fields(line);
+                    std::string name;
+                    if (!(fields >> name)) {
+                        continue;
+                    }
+                    if (name == "hash_type") {
+                        std::string model_hash_type;
+                        if (!(fields >> model_hash_type)) {
+                            BOOST_LOG_TRIVIAL(error) << "Invalid cost model line " << line_number << " in " << path;
+                            return std::nullopt;
+                        }
+                        if (model_hash_type != hash_type) {
+                            BOOST_LOG_TRIVIAL(error) << "Cost model " << path << " is fitted for " << model_hash_type
+                                                     << " hashes, the proof uses " << hash_type;
+                            return std::nullopt;
+                        }
+                        continue;
+                    }
+                    auto quantity = quantity_from_name(name);
+                    Term term;
+                    std::string rest;
+                    if (!quantity || !(fields >> term.intercept >> term.slope) || (fields >> rest)) {
+                        BOOST_LOG_TRIVIAL(error) << "Invalid cost model line " << line_number << " in " << path;
+                        return std::nullopt;
+                    }
+                    model.terms_[static_cast<std::size_t>(*quantity)] = term;
+                    model.fitted_[static_cast<std::size_t>(*quantity)] = true;
+                }
+                return model;
+            }
+
+            static Features features(const CircuitShape& shape, const ProofParameters& parameters) {
+                const ArgumentSize size(shape, parameters);
+                const double extended_rows = std::ldexp(1.0, size.extended_rows_log);
+                const double butterflies = extended_rows * size.extended_rows_log;
+                const double preprocessed_polynomials =
+                    shape.constant_columns + shape.selector_columns + 2.0 * size.permuted_columns;
+                const double proving_polynomials = shape.witness_columns + size.permutation_polynomials +
+                                                   size.lookup_polynomials + size.quotient_chunks;
+                const double all_polynomials =
+                    preprocessed_polynomials + shape.public_input_columns + proving_polynomials;
+                // Every query opens all the polynomials at a point and its pair, and one Merkle path per FRI round.
+                const double query_openings_bytes =
+                    parameters.lambda * (2.0 * all_polynomials * shape.element_size +
+                                         double(size.extended_rows_log) * size.extended_rows_log * shape.digest_size);
+                const double preprocessed_bytes = preprocessed_polynomials * extended_rows * shape.element_size;
+
+                Features result;
+                result[index(Quantity::PREPROCESS_CPU_SECONDS)] = preprocessed_polynomials * butterflies;
+                result[index(Quantity::PROVE_CPU_SECONDS)] =
+                    proving_polynomials * butterflies + double(shape.constraints_amount) * extended_rows;
+                result[index(Quantity::VERIFY_CPU_SECONDS)] = query_openings_bytes;
+                result[index(Quantity::PREPROCESS_PEAK_RSS_BYTES)] = preprocessed_bytes;
+                result[index(Quantity::PROVE_PEAK_RSS_BYTES)] = all_polynomials * extended_rows * shape.element_size;
+                result[index(Quantity::VERIFY_PEAK_RSS_BYTES)] = query_openings_bytes;
+                result[index(Quantity::PREPROCESSED_DATA_BYTES)] = preprocessed_bytes;
+                result[index(Quantity::PROOF_BYTES)] = query_openings_bytes;
+                return result;
+            }
+
+            // Whether every quantity comes from a fitted model rather than the defaults.
+            bool calibrated() const {
+                return std::all_of(fitted_.begin(), fitted_.end(), [](bool fitted) { return fitted; });
+            }
+
+            double predict(Quantity quantity, const Features& features) const {
+                const Term& term = terms_[index(quantity)];
+                return std::max(0.0, term.intercept + term.slope * features[index(quantity)]);
+            }
+
+            // Lambda, expand factor and quotient chunks of at least security_bits of conjectured security that
+            // minimize the predicted proving CPU time, proving peak RSS or proof size. Ties are broken by the
+            // proving CPU time. Grinding is not tuned, its bits are taken off the bits the queries must give.
+            ProofParameters tune(
+                const CircuitShape& shape,
+                TuningObjective objective,
+                std::size_t security_bits,
+                std::size_t grind
+            ) const {
+                const Quantity objective_quantity = objective == TuningObjective::LATENCY ? Quantity::PROVE_CPU_SECONDS
+                                                    : objective == TuningObjective::MEMORY
+                                                        ? Quantity::PROVE_PEAK_RSS_BYTES
+                                                        : Quantity::PROOF_BYTES;
+                const std::size_t query_bits = security_bits > grind ? security_bits - grind : 1;
+
+                std::optional<ProofParameters> best;
+                std::pair<double, double> best_cost;
+                for (std::size_t expand_factor = 1; expand_factor <= max_tuned_expand_factor; ++expand_factor) {
+                    for (std::size_t max_quotient_chunks = 0; max_quotient_chunks <= max_tuned_quotient_chunks;
+                         max_quotient_chunks += max_quotient_chunks == 0 ? 2 : 1) {
+                        const ProofParameters candidate {
+                            (query_bits + expand_factor - 1) / expand_factor,
+                            expand_factor,
+                            max_quotient_chunks,
+                            grind
+                        };
+                        const Features values = features(shape, candidate);
+                        const std::pair<double, double> cost = {
+                            predict(objective_quantity, values),
+                            predict(Quantity::PROVE_CPU_SECONDS, values)
+                        };
+                        if (!best || cost < best_cost) {
+                            best = candidate;
+                            best_cost = cost;
+                        }
+                    }
+                }
+                return *best;
+            }
+
+            // One value per line, so that tests/fit_cost_model.sh can pick the features up without a JSON parser.
+            std::string estimate_json(const CircuitShape& shape, const ProofParameters& parameters) const {
+                const ArgumentSize size(shape, parameters);
+                const Features values = features(shape, parameters);
+                auto bytes = [&](Quantity quantity) {
+                    return std::to_string(std::llround(predict(quantity, values)));
+                };
+                auto seconds = [&](Quantity quantity) {
+                    std::ostringstream out;
+                    out << predict(quantity, values);
+                    return out.str();
+                };
+
+                std::ostringstream out;
+                out.precision(12);
+                out << "{\n";
+                out << "  \"calibrated\": " << (calibrated() ? "true" : "false") << ",\n";
+                out << "  \"parameters\": {\n";
+                out << "    \"lambda\": " << parameters.lambda << ",\n";
+                out << "    \"expand_factor\": " << parameters.expand_factor << ",\n";
+                out << "    \"max_quotient_chunks\": " << parameters.max_quotient_chunks << ",\n";
+                out << "    \"grind\": " << parameters.grind << "\n";
+                out << "  },\n";
+                out << "  \"shape\": {\n";
+                out << "    \"rows_amount\": " << shape.rows_amount << ",\n";
+                out << "    \"witness_columns\": " << shape.witness_columns << ",\n";
+                out << "    \"public_input_columns\": " << shape.public_input_columns << ",\n";
+                out << "    \"constant_columns\": " << shape.constant_columns << ",\n";
+                out << "    \"selector_columns\": " << shape.selector_columns << ",\n";
+                out << "    \"gates_amount\": " << shape.gates_amount << ",\n";
+                out << "    \"constraints_amount\": " << shape.constraints_amount << ",\n";
+                out << "    \"max_gate_degree\": " << shape.max_gate_degree << ",\n";
+                out << "    \"lookup_gates_amount\": " << shape.lookup_gates_amount << ",\n";
+                out << "    \"permutation_polynomials\": " << size.permutation_polynomials << ",\n";
+                out << "    \"quotient_chunks\": " << size.quotient_chunks << "\n";
+                out << "  },\n";
+                out << "  \"features\": {\n";
+                for (std::size_t i = 0; i < quantities_amount; ++i) {
+                    out << "    \"" << quantity_names[i] << "\": " << values[i]
+                        << (i + 1 < quantities_amount ? ",\n" : "\n");
+                }
+                out << "  },\n";
+                out << "  \"preprocessed_data_bytes\": " << bytes(Quantity::PREPROCESSED_DATA_BYTES) << ",\n";
+                out << "  \"proof_bytes\": " << bytes(Quantity::PROOF_BYTES) << ",\n";
+                out << "  \"stages\": {\n";
+                out << "    \"preprocess\": {\"cpu_seconds\": " << seconds(Quantity::PREPROCESS_CPU_SECONDS)
+                    << ", \"peak_rss_bytes\": " << bytes(Quantity::PREPROCESS_PEAK_RSS_BYTES) << "},\n";
+                out << "    \"prove\": {\"cpu_seconds\": " << seconds(Quantity::PROVE_CPU_SECONDS)
+                    << ", \"peak_rss_bytes\": " << bytes(Quantity::PROVE_PEAK_RSS_BYTES) << "},\n";
+                out << "    \"verify\": {\"cpu_seconds\": " << seconds(Quantity::VERIFY_CPU_SECONDS)
+                    << ", \"peak_rss_bytes\": " << bytes(Quantity::VERIFY_PEAK_RSS_BYTES) << "}\n";
+                out << "  }\n";
+                out << "}\n";
+                return out.str();
+            }
+
+        private:
+            static std::size_t index(Quantity quantity) {
+                return static_cast<std::size_t>(quantity);
+            }
+
+            static std::optional<Quantity> quantity_from_name(const std::string& name) {
+                for (std::size_t i = 0; i < quantities_amount; ++i) {
+                    if (name == quantity_names[i]) {
+                        return static_cast<Quantity>(i);
+                    }
+                }
+                return std::nullopt;
+            }
+
+            std::array<Term, quantities_amount> terms_;
+            std::array<bool, quantities_amount> fitted_;
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_COST_MODEL_HPP
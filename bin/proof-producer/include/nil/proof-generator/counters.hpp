@@ -0,0 +1,189 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_COUNTERS_HPP
+#define PROOF_GENERATOR_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+
+// Work counters of the hot paths. They are compiled in only with PROOF_GENERATOR_COUNTERS_ENABLED, otherwise
+// PROOF_GENERATOR_COUNT expands to nothing.
+#ifdef PROOF_GENERATOR_COUNTERS_ENABLED
+#define PROOF_GENERATOR_COUNT(counter, amount) \
+    ::nil::proof_generator::Counters::add(::nil::proof_generator::Counter::counter, amount)
+#else
+#define PROOF_GENERATOR_COUNT(counter, amount) ((void)0)
+#endif
+
+namespace nil {
+    namespace proof_generator {
+
+        enum class Counter : std::size_t {
+            CELLS_DECODED,
+            CELLS_ENCODED,
+            COLUMNS_DECODED,
+            BYTES_MARSHALLED,
+            BYTES_UNMARSHALLED,
+            BYTES_COMPRESSED,
+            BYTES_DECOMPRESSED,
+            CHALLENGES_ABSORBED,
+            PROOFS_GENERATED,
+            PROOFS_VERIFIED,
+            COUNTERS_AMOUNT
+        };
+
+        struct CounterDescription {
+            const char* name;
+            const char* help;
+        };
+
+        constexpr std::size_t counters_amount = static_cast<std::size_t>(Counter::COUNTERS_AMOUNT);
+
+        constexpr CounterDescription counter_descriptions[counters_amount] = {
+            {"cells_decoded", "Assignment table cells decoded into field elements"},
+            {"cells_encoded", "Assignment table cells encoded from field elements"},
+            {"columns_decoded", "Assignment table columns decoded"},
+            {"bytes_marshalled", "Bytes produced by marshalling"},
+            {"bytes_unmarshalled", "Bytes consumed by unmarshalling"},
+            {"bytes_compressed", "Uncompressed bytes fed to the compressor"},
+            {"bytes_decompressed", "Bytes produced by the decompressor"},
+            {"challenges_absorbed", "Challenges absorbed into the aggregated challenge transcript"},
+            {"proofs_generated", "Placeholder proofs generated"},
+            {"proofs_verified", "Placeholder proofs verified successfully"},
+        };
+
+        // Counters are kept per thread, so that counting is a plain relaxed increment of a thread-owned value,
+        // and summed up over the live threads and the ones that already exited when read.
+        class Counters {
+        public:
+            using Values = std::array<std::uint64_t, counters_amount>;
+
+            static void add(Counter counter, std::uint64_t amount) {
+                auto& value = thread_block().values[static_cast<std::size_t>(counter)];
+                value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            }
+
+            static Values totals() {
+                Registry& registry = Registry::instance();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                Values result = registry.exited_threads_totals;
+                for (const ThreadBlock* block : registry.blocks) {
+                    for (std::size_t i = 0; i < counters_amount; ++i) {
+                        result[i] += block->values[i].load(std::memory_order_relaxed);
+                    }
+                }
+                return result;
+            }
+
+            // Prometheus text exposition format, every counter gets the given labels.
+            static bool write_prometheus(
+                const boost::filesystem::path& path,
+                const std::map<std::string, std::string>& labels
+            ) {
+                std::string label_set;
+                for (const auto& [key, value] : labels) {
+                    label_set += (label_set.empty() ? "{" : ",") + key + "=\"" + escape_label(value) + "\"";
+                }
+                if (!label_set.empty()) {
+                    label_set += "}";
+                }
+
+                const Values values = totals();
+                std::ostringstream out;
+                for (std::size_t i = 0; i < counters_amount; ++i) {
+                    const std::string name = std::string("proof_producer_") + counter_descriptions[i].name + "_total";
+                    out << "# HELP " << name << " " << counter_descriptions[i].help << "\n";
+                    out << "# TYPE " << name << " counter\n";
+                    out << name << label_set << " " << values[i] << "\n";
+                }
+
+                std::ofstream file(path.string(), std::ios_base::out | std::ios_base::trunc);
+                file << out.str();
+                if (!file) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to write counters to " << path;
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            struct ThreadBlock;
+
+            struct Registry {
+                static Registry& instance() {
+                    static Registry registry;
+                    return registry;
+                }
+
+                std::mutex mutex;
+                std::set<const ThreadBlock*> blocks;
+                Values exited_threads_totals {};
+            };
+
+            struct ThreadBlock {
+                ThreadBlock() {
+                    Registry& registry = Registry::instance();
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    registry.blocks.insert(this);
+                }
+
+                ~ThreadBlock() {
+                    Registry& registry = Registry::instance();
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    for (std::size_t i = 0; i < counters_amount; ++i) {
+                        registry.exited_threads_totals[i] += values[i].load(std::memory_order_relaxed);
+                    }
+                    registry.blocks.erase(this);
+                }
+
+                std::array<std::atomic<std::uint64_t>, counters_amount> values {};
+            };
+
+            static ThreadBlock& thread_block() {
+                // The registry must outlive the thread blocks of the main thread.
+                Registry::instance();
+                thread_local ThreadBlock block;
+                return block;
+            }
+
+            static std::string escape_label(const std::string& value) {
+                std::string result;
+                for (char c : value) {
+                    if (c == '\\' || c == '"') {
+                        result += '\\';
+                    }
+                    result += c == '\n' ? std::string("\\n") : std::string(1, c);
+                }
+                return result;
+            }
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_COUNTERS_HPP
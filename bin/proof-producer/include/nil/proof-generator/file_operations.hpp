@@ -17,15 +17,28 @@
 #ifndef PROOF_GENERATOR_FILE_OPERATIONS_HPP
 #define PROOF_GENERATOR_FILE_OPERATIONS_HPP
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <optional>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <boost/filesystem.hpp>
 #include <boost/log/trivial.hpp>
 
+#include <nil/proof-generator/file_sink.hpp>
+#include <nil/proof-generator/hex.hpp>
+#include <nil/proof-generator/metrics.hpp>
+
 namespace nil {
     namespace proof_generator {
         inline bool is_valid_path(const std::string& path) {
@@ -43,48 +56,87 @@ namespace nil {
             return true;
         }
 
+        // "-" is the standard input.
         inline bool can_read_from_file(const std::string& path) {
+            if (path == "-") {
+                return true;
+            }
             if (!is_valid_path(path)) {
                 return false;
             }
-
-            std::ifstream file(path, std::ios::in);
-            bool can_read = file.is_open();
-            file.close();
-            return can_read;
+            return ::access(path.c_str(), R_OK) == 0;
         }
 
+        // Checks permissions without touching the file system. Descriptors and existing non-regular files (pipes,
+        // devices) are written in place, regular files are written to a temporary file next to them and renamed
+        // into place, which needs a writable parent directory.
         inline bool can_write_to_file(const std::string& path) {
+            auto stream_fd = output_stream_fd(path);
+            if (stream_fd) {
+                int flags = ::fcntl(*stream_fd, F_GETFL);
+                return flags >= 0 && (flags & O_ACCMODE) != O_RDONLY;
+            }
             if (!is_valid_path(path)) {
                 return false;
             }
 
-            if (boost::filesystem::exists(path)) {
-                std::ofstream file(path, std::ios::out | std::ios::app);
-                bool can_write = file.is_open();
-                return can_write;
-            } else {
-                boost::filesystem::path boost_path = boost::filesystem::absolute(path);
-                boost::filesystem::path parent_dir = boost_path.parent_path();
-                if (parent_dir.empty()) {
-                    BOOST_LOG_TRIVIAL(error) << "Proof parent dir is empty. Seems like you "
-                                                "are passing an empty string.";
-                    return false;
-                }
-                if (!boost::filesystem::exists(parent_dir)) {
-                    BOOST_LOG_TRIVIAL(error) << boost_path << ": proof parent dir does not exist. Create it first.";
-                    return false;
-                }
-                std::string temp_file_name = (parent_dir / "temp_file_to_test_write_permission").string();
-                std::ofstream temp_file(temp_file_name, std::ios::out);
-                bool can_write = temp_file.is_open();
-                temp_file.close();
+            boost::system::error_code ec;
+            if (boost::filesystem::exists(path, ec) && !boost::filesystem::is_regular_file(path, ec)) {
+                return ::access(path.c_str(), W_OK) == 0;
+            }
+            boost::filesystem::path boost_path = boost::filesystem::absolute(path);
+            boost::filesystem::path parent_dir = boost_path.parent_path();
+            if (parent_dir.empty()) {
+                BOOST_LOG_TRIVIAL(error) << "Proof parent dir is empty. Seems like you "
+                                            "are passing an empty string.";
+                return false;
+            }
+            if (!boost::filesystem::exists(parent_dir)) {
+                BOOST_LOG_TRIVIAL(error) << boost_path << ": proof parent dir does not exist. Create it first.";
+                return false;
+            }
+            return ::access(parent_dir.c_str(), W_OK | X_OK) == 0;
+        }
 
-                if (can_write) {
-                    boost::filesystem::remove(temp_file_name);
-                }
-                return can_write;
+        // Outputs that can't be replaced by renaming a temporary file: descriptors, pipes, devices.
+        inline bool is_output_stream(const std::string& path) {
+            boost::system::error_code ec;
+            return output_stream_fd(path).has_value() ||
+                   (boost::filesystem::exists(path, ec) && !boost::filesystem::is_regular_file(path, ec));
+        }
+
+        // Opens an input for sequential reading, "-" is the standard input. The descriptor is owned by the caller.
+        inline int open_input_fd(const std::string& path) {
+            int fd = path == "-" ? ::fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0)
+                                 : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to open file: " << path << ": " << std::strerror(errno);
+            }
+            return fd;
+        }
+
+        // Outputs are written next to their destination first, so that renaming them into place is atomic.
+        inline boost::filesystem::path temporary_path_for(const boost::filesystem::path& path) {
+            return boost::filesystem::path(path.string() + ".tmp." + std::to_string(::getpid()));
+        }
+
+        inline bool commit_temporary_file(
+            const boost::filesystem::path& temporary_path,
+            const boost::filesystem::path& path
+        ) {
+            boost::system::error_code ec;
+            boost::filesystem::rename(temporary_path, path, ec);
+            if (ec) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to move " << temporary_path << " to " << path << ": "
+                                         << ec.message();
+                return false;
             }
+            return true;
+        }
+
+        inline void remove_temporary_file(const boost::filesystem::path& temporary_path) {
+            boost::system::error_code ec;
+            boost::filesystem::remove(temporary_path, ec);
         }
 
         template<typename StreamType>
@@ -98,92 +150,288 @@ namespace nil {
             return file;
         }
 
-        std::optional<std::vector<std::uint8_t>> read_file_to_vector(const std::string& path) {
+        // Read-only mapping of a whole file into memory, unmapped on destruction.
+        class MappedFile {
+        public:
+            MappedFile(void* data, std::size_t size)
+                : data_(data)
+                , size_(size) {
+            }
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+            MappedFile(MappedFile&& other) noexcept
+                : data_(std::exchange(other.data_, nullptr))
+                , size_(std::exchange(other.size_, 0)) {
+            }
+            MappedFile& operator=(MappedFile&& other) noexcept {
+                std::swap(data_, other.data_);
+                std::swap(size_, other.size_);
+                return *this;
+            }
+            ~MappedFile() {
+                if (data_ != nullptr) {
+                    ::munmap(data_, size_);
+                }
+            }
 
-            auto file = open_file<std::ifstream>(path, std::ios_base::in | std::ios::binary | std::ios::ate);
-            if (!file.has_value()) {
-                return std::nullopt;
+            const std::uint8_t* data() const {
+                return static_cast<const std::uint8_t*>(data_);
             }
 
-            std::ifstream& stream = file.value();
-            std::streamsize fsize = stream.tellg();
-            stream.seekg(0, std::ios::beg);
-            std::vector<std::uint8_t> v(static_cast<size_t>(fsize));
+            std::size_t size() const {
+                return size_;
+            }
 
-            stream.read(reinterpret_cast<char*>(v.data()), fsize);
+        private:
+            void* data_;
+            std::size_t size_;
+        };
+
+        // Maps the regular file open as fd for a single sequential pass, the descriptor stays open. Returns nullopt
+        // for anything mmap can't handle (pipes, character devices, ...), callers are expected to fall back to
+        // read_fd_to_vector on the same descriptor.
+        // Callers that are going to skip parts of the file pass populate = false, so that only the touched pages
+        // are read, and account the bytes read themselves.
+        inline std::optional<MappedFile> map_file_to_memory(int fd, const std::string& path, bool populate = true) {
+            struct stat file_stat;
+            if (::fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+                return std::nullopt;
+            }
+            std::size_t size = static_cast<std::size_t>(file_stat.st_size);
+            if (size == 0) {
+                return MappedFile(nullptr, 0);
+            }
 
-            if (stream.fail()) {
-                BOOST_LOG_TRIVIAL(error) << "Error occurred during reading file " << path;
+            // The whole file is going to be decoded right away, ask the kernel to read it ahead.
+            TraceSpan span("io", populate ? "read" : "map", path);
+            void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+            if (data == MAP_FAILED) {
                 return std::nullopt;
             }
+            ::madvise(data, size, MADV_SEQUENTIAL);
+            if (populate) {
+                Metrics::instance().add_bytes_read(size);
+            }
+            return MappedFile(data, size);
+        }
+
+        // Reads fd to its end. Works for pipes and the standard input as well, their size is not known in advance.
+        inline std::optional<std::vector<std::uint8_t>> read_fd_to_vector(int fd, const std::string& path) {
+            TraceSpan span("io", "read", path);
+            // A byte more than the size of a regular file, so that reaching its end doesn't grow the buffer.
+            std::vector<std::uint8_t> v;
+            struct stat file_stat;
+            if (::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+                v.resize(static_cast<std::size_t>(file_stat.st_size) + 1);
+            }
+            constexpr std::size_t min_read_size = 1 << 20;
+            std::size_t size = 0;
+            while (true) {
+                if (size == v.size()) {
+                    v.resize(std::max(2 * size, size + min_read_size));
+                }
+                ssize_t amount = ::read(fd, v.data() + size, v.size() - size);
+                if (amount < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (amount < 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Error occurred during reading file " << path << ": "
+                                             << std::strerror(errno);
+                    return std::nullopt;
+                }
+                if (amount == 0) {
+                    break;
+                }
+                size += static_cast<std::size_t>(amount);
+            }
+            v.resize(size);
+            Metrics::instance().add_bytes_read(v.size());
 
             return v;
         }
 
-        bool write_vector_to_file(const std::vector<std::uint8_t>& vector, const std::string& path) {
+        // An input opened once for all the ways of reading it: regular files are mapped, anything else (FIFOs,
+        // pipes, the standard input as "-") is read through the same descriptor. Opening a FIFO again would leave
+        // its writer without a reader in between, failing its writes with EPIPE.
+        class InputFile {
+        public:
+            static std::optional<InputFile> open(const std::string& path) {
+                int fd = open_input_fd(path);
+                if (fd < 0) {
+                    return std::nullopt;
+                }
+                return InputFile(fd, path);
+            }
+
+            InputFile(const InputFile&) = delete;
+            InputFile& operator=(const InputFile&) = delete;
+            InputFile(InputFile&& other) noexcept
+                : fd_(std::exchange(other.fd_, -1))
+                , path_(std::move(other.path_)) {
+            }
+            InputFile& operator=(InputFile&& other) noexcept {
+                std::swap(fd_, other.fd_);
+                std::swap(path_, other.path_);
+                return *this;
+            }
+            ~InputFile() {
+                if (fd_ >= 0) {
+                    ::close(fd_);
+                }
+            }
 
-            auto file = open_file<std::ofstream>(path, std::ios_base::out | std::ios_base::binary);
-            if (!file.has_value()) {
-                return false;
+            int fd() const {
+                return fd_;
             }
 
-            std::ofstream& stream = file.value();
-            stream.write(reinterpret_cast<const char*>(vector.data()), vector.size());
+            const std::string& path() const {
+                return path_;
+            }
 
-            if (stream.fail()) {
-                BOOST_LOG_TRIVIAL(error) << "Error occured during writing file " << path;
-                return false;
+            // nullopt when the input is not a regular file and has to be read sequentially from fd().
+            std::optional<MappedFile> map(bool populate = true) const {
+                if (path_ == "-") {
+                    return std::nullopt;
+                }
+                return map_file_to_memory(fd_, path_, populate);
             }
 
-            return true;
+            std::optional<std::vector<std::uint8_t>> read_to_vector() const {
+                return read_fd_to_vector(fd_, path_);
+            }
+
+        private:
+            InputFile(int fd, std::string path)
+                : fd_(fd)
+                , path_(std::move(path)) {
+            }
+
+            int fd_;
+            std::string path_;
+        };
+
+        std::optional<std::vector<std::uint8_t>> read_file_to_vector(const std::string& path) {
+            auto input = InputFile::open(path);
+            if (!input) {
+                return std::nullopt;
+            }
+            return input->read_to_vector();
+        }
+
+        // Reads a file of at most capacity bytes into buffer, without allocations. Returns the file size.
+        inline std::optional<std::size_t> read_small_file(
+            const std::string& path,
+            std::uint8_t* buffer,
+            std::size_t capacity
+        ) {
+            TraceSpan span("io", "read", path);
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to open file: " << path;
+                return std::nullopt;
+            }
+            std::size_t size = 0;
+            bool ok = true;
+            while (ok) {
+                std::uint8_t extra_byte;
+                // Once the buffer is full, read one more byte to find out whether the file is longer.
+                bool full = size == capacity;
+                ssize_t amount = full ? ::read(fd, &extra_byte, 1) : ::read(fd, buffer + size, capacity - size);
+                if (amount < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (amount < 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Error occurred during reading file " << path;
+                    ok = false;
+                } else if (amount == 0) {
+                    break;
+                } else if (full) {
+                    BOOST_LOG_TRIVIAL(error) << path << " is larger than " << capacity << " bytes";
+                    ok = false;
+                } else {
+                    size += amount;
+                }
+            }
+            ::close(fd);
+            if (!ok) {
+                return std::nullopt;
+            }
+            Metrics::instance().add_bytes_read(size);
+            return size;
+        }
+
+        bool write_vector_to_file(
+            const std::vector<std::uint8_t>& vector,
+            const std::string& path,
+            bool async = false
+        ) {
+            auto sink = FileSink::open(path, async);
+            if (!sink) {
+                return false;
+            }
+            sink->write(reinterpret_cast<const char*>(vector.data()), vector.size());
+            return sink->close();
         }
 
         // HEX data format is not efficient, we will remove it later
         std::optional<std::vector<std::uint8_t>> read_hex_file_to_vector(const std::string& path) {
-            auto file = open_file<std::ifstream>(path, std::ios_base::in);
-            if (!file.has_value()) {
+            auto input = InputFile::open(path);
+            if (!input) {
                 return std::nullopt;
             }
+            std::optional<std::vector<std::uint8_t>> buffered;
+            auto mapped = input->map();
+            if (!mapped.has_value()) {
+                buffered = input->read_to_vector();
+                if (!buffered.has_value()) {
+                    return std::nullopt;
+                }
+            }
+            const char* position = reinterpret_cast<const char*>(mapped ? mapped->data() : buffered->data());
+            const char* end = position + (mapped ? mapped->size() : buffered->size());
+
+            std::vector<std::uint8_t> result;
+            result.reserve((end - position) / 2);
+            while (position < end) {
+                const char* line_end = std::find(position, end, '\n');
+                std::size_t line_length = line_end - position;
+                if (line_length < 3 || position[0] != '0' || position[1] != 'x' || line_length % 2 != 0) {
+                    BOOST_LOG_TRIVIAL(error) << "File contains non-hex string";
+                    return std::nullopt;
+                }
 
-            std::ifstream& stream = file.value();
-            std::vector<uint8_t> result;
-            std::string line;
-            while (std::getline(stream, line)) {
-                if (line.rfind("0x", 0) == 0 && line.length() >= 3) {
-                    for (size_t i = 2; i < line.length(); i += 2) {
-                        std::string hex_string = line.substr(i, 2);
-                        uint8_t byte = static_cast<uint8_t>(std::stoul(hex_string, nullptr, 16));
-                        result.push_back(byte);
-                    }
-                } else {
+                std::size_t bytes_amount = (line_length - 2) / 2;
+                std::size_t offset = result.size();
+                result.resize(offset + bytes_amount);
+                if (!hex::decode(position + 2, bytes_amount, result.data() + offset)) {
                     BOOST_LOG_TRIVIAL(error) << "File contains non-hex string";
                     return std::nullopt;
                 }
+                position = line_end + 1;
             }
 
             return result;
         }
 
-        bool write_vector_to_hex_file(const std::vector<std::uint8_t>& vector, const std::string& path) {
-            auto file = open_file<std::ofstream>(path, std::ios_base::out);
-            if (!file.has_value()) {
+        bool write_vector_to_hex_file(
+            const std::vector<std::uint8_t>& vector,
+            const std::string& path,
+            bool async = false
+        ) {
+            auto sink = FileSink::open(path, async);
+            if (!sink) {
                 return false;
             }
 
-            std::ofstream& stream = file.value();
-
-            stream << "0x" << std::hex;
-            for (auto it = vector.cbegin(); it != vector.cend(); ++it) {
-                stream << std::setfill('0') << std::setw(2) << std::right << int(*it);
-            }
-            stream << std::dec;
-
-            if (stream.fail()) {
-                BOOST_LOG_TRIVIAL(error) << "Error occurred during writing to file " << path;
-                return false;
+            constexpr std::size_t chunk_size = 32 * 1024;
+            std::vector<char> buffer(2 * chunk_size);
+            sink->write("0x", 2);
+            for (std::size_t offset = 0; offset < vector.size(); offset += chunk_size) {
+                std::size_t bytes_amount = std::min(chunk_size, vector.size() - offset);
+                hex::encode(vector.data() + offset, bytes_amount, buffer.data());
+                sink->write(buffer.data(), 2 * bytes_amount);
             }
-
-            return true;
+            return sink->close();
         }
 
     } // namespace proof_generator
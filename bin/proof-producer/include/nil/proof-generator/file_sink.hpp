@@ -0,0 +1,213 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_FILE_SINK_HPP
+#define PROOF_GENERATOR_FILE_SINK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+#include <nil/proof-generator/metrics.hpp>
+
+namespace nil {
+    namespace proof_generator {
+
+        // "-" is the standard output, "/dev/fd/<n>" is an inherited descriptor. Such outputs are written to
+        // directly, they can't be replaced atomically like regular files.
+        inline std::optional<int> output_stream_fd(const std::string& path) {
+            if (path == "-" || path == "/dev/stdout") {
+                return STDOUT_FILENO;
+            }
+            const std::string fd_prefix = "/dev/fd/";
+            if (path.size() > fd_prefix.size() && path.size() < fd_prefix.size() + 10 &&
+                path.compare(0, fd_prefix.size(), fd_prefix) == 0 &&
+                std::all_of(path.begin() + fd_prefix.size(), path.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                return std::stoi(path.substr(fd_prefix.size()));
+            }
+            return std::nullopt;
+        }
+
+        // Buffered output file for writing data piece by piece. In asynchronous mode filled buffers are written
+        // by a background thread, so producing the data overlaps with the disk writes. Memory is bounded by
+        // max_queued_buffers: writers block while that many buffers are waiting for the disk.
+        class FileSink {
+        public:
+            static constexpr std::size_t buffer_size = 1 << 20;
+            static constexpr std::size_t max_queued_buffers = 4;
+
+            static std::unique_ptr<FileSink> open(const std::string& path, bool async) {
+                // Streams are written through a duplicate, so closing the sink leaves the original descriptor open.
+                auto stream_fd = output_stream_fd(path);
+                int fd = stream_fd ? ::fcntl(*stream_fd, F_DUPFD_CLOEXEC, 0)
+                                   : ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd < 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to open file: " << path << ": " << std::strerror(errno);
+                    return nullptr;
+                }
+                return std::unique_ptr<FileSink>(new FileSink(path, fd, async));
+            }
+
+            FileSink(const FileSink&) = delete;
+            FileSink& operator=(const FileSink&) = delete;
+
+            ~FileSink() {
+                close();
+            }
+
+            void write(const char* data, std::size_t size) {
+                // Without a writer thread nothing has to outlive the call, large pieces skip the buffer.
+                if (!writer_.joinable() && size >= buffer_size) {
+                    flush_buffer();
+                    write_fully(data, size);
+                    return;
+                }
+                while (size > 0) {
+                    std::size_t amount = std::min(size, buffer_size - buffer_.size());
+                    buffer_.insert(buffer_.end(), data, data + amount);
+                    data += amount;
+                    size -= amount;
+                    if (buffer_.size() == buffer_size) {
+                        flush_buffer();
+                    }
+                }
+            }
+
+            void write(const std::string& data) {
+                write(data.data(), data.size());
+            }
+
+            // Writes out everything buffered and closes the file. Returns false if any of the writes failed.
+            bool close() {
+                if (fd_ < 0) {
+                    return ok_;
+                }
+                flush_buffer();
+                if (writer_.joinable()) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        closing_ = true;
+                    }
+                    queue_changed_.notify_all();
+                    writer_.join();
+                }
+                if (::close(fd_) != 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Error occurred during closing file " << path_;
+                    ok_ = false;
+                }
+                fd_ = -1;
+                return ok_;
+            }
+
+        private:
+            FileSink(std::string path, int fd, bool async)
+                : path_(std::move(path))
+                , fd_(fd) {
+                buffer_.reserve(buffer_size);
+                if (async) {
+                    writer_ = std::thread([this] { write_queued_buffers(); });
+                }
+            }
+
+            void flush_buffer() {
+                if (buffer_.empty()) {
+                    return;
+                }
+                if (!writer_.joinable()) {
+                    write_fully(buffer_.data(), buffer_.size());
+                    buffer_.clear();
+                    return;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    queue_changed_.wait(lock, [this] { return queue_.size() < max_queued_buffers; });
+                    queue_.push_back(std::move(buffer_));
+                }
+                queue_changed_.notify_all();
+                buffer_ = std::vector<char>();
+                buffer_.reserve(buffer_size);
+            }
+
+            void write_queued_buffers() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (true) {
+                    queue_changed_.wait(lock, [this] { return !queue_.empty() || closing_; });
+                    if (queue_.empty()) {
+                        return;
+                    }
+                    std::vector<char> buffer = std::move(queue_.front());
+                    queue_.pop_front();
+                    lock.unlock();
+                    queue_changed_.notify_all();
+                    write_fully(buffer.data(), buffer.size());
+                    lock.lock();
+                }
+            }
+
+            void write_fully(const char* data, std::size_t size) {
+                if (!ok_) {
+                    return;
+                }
+                TraceSpan span("io", "write", path_);
+                const char* position = data;
+                std::size_t remaining = size;
+                while (remaining > 0) {
+                    ssize_t written = ::write(fd_, position, remaining);
+                    if (written < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        BOOST_LOG_TRIVIAL(error) << "Error occurred during writing to file " << path_ << ": "
+                                                 << std::strerror(errno);
+                        ok_ = false;
+                        return;
+                    }
+                    position += written;
+                    remaining -= written;
+                }
+                Metrics::instance().add_bytes_written(size);
+            }
+
+            const std::string path_;
+            int fd_;
+            std::atomic<bool> ok_ {true};
+            std::vector<char> buffer_;
+
+            std::thread writer_;
+            std::mutex mutex_;
+            std::condition_variable queue_changed_;
+            std::deque<std::vector<char>> queue_;
+            bool closing_ = false;
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_FILE_SINK_HPP
@@ -0,0 +1,249 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_HEX_HPP
+#define PROOF_GENERATOR_HEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#define PROOF_GENERATOR_HEX_X86_64
+#include <immintrin.h>
+#endif
+
+// Hex codec for the proof files. Vectorized with SSE2, which every x86-64 CPU has, and with AVX2 when the
+// CPU running the binary supports it. Other architectures use the scalar code.
+namespace nil {
+    namespace proof_generator {
+        namespace hex {
+            namespace detail {
+                inline void encode_scalar(const std::uint8_t* in, std::size_t size, char* out) {
+                    static constexpr char digits[] = "0123456789abcdef";
+                    for (std::size_t i = 0; i < size; ++i) {
+                        out[2 * i] = digits[in[i] >> 4];
+                        out[2 * i + 1] = digits[in[i] & 0x0f];
+                    }
+                }
+
+                // Returns 0xff for a non-hex character.
+                inline std::uint8_t nibble_from_char(char c) {
+                    if (c >= '0' && c <= '9') {
+                        return c - '0';
+                    }
+                    if (c >= 'a' && c <= 'f') {
+                        return c - 'a' + 10;
+                    }
+                    if (c >= 'A' && c <= 'F') {
+                        return c - 'A' + 10;
+                    }
+                    return 0xff;
+                }
+
+                inline bool decode_scalar(const char* in, std::size_t size, std::uint8_t* out) {
+                    for (std::size_t i = 0; i < size; ++i) {
+                        std::uint8_t high = nibble_from_char(in[2 * i]);
+                        std::uint8_t low = nibble_from_char(in[2 * i + 1]);
+                        if ((high | low) & 0xf0) {
+                            return false;
+                        }
+                        out[i] = (high << 4) | low;
+                    }
+                    return true;
+                }
+
+#ifdef PROOF_GENERATOR_HEX_X86_64
+                // Nibbles 0..15 to ASCII: n + '0', plus ('a' - '0' - 10) for n > 9.
+                inline __m128i nibbles_to_ascii_sse2(__m128i nibbles) {
+                    __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+                    return _mm_add_epi8(
+                        _mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                        _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10))
+                    );
+                }
+
+                inline std::size_t encode_sse2(const std::uint8_t* in, std::size_t size, char* out) {
+                    const __m128i low_mask = _mm_set1_epi8(0x0f);
+                    std::size_t i = 0;
+                    for (; i + 16 <= size; i += 16) {
+                        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                        __m128i high = nibbles_to_ascii_sse2(_mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask));
+                        __m128i low = nibbles_to_ascii_sse2(_mm_and_si128(bytes, low_mask));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+                    }
+                    return i;
+                }
+
+                // Converts 16 characters into nibbles, sets `valid` to false if any of them is not a hex digit.
+                inline __m128i ascii_to_nibbles_sse2(__m128i chars, bool& valid) {
+                    __m128i digit = _mm_and_si128(
+                        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1))
+                    );
+                    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+                    __m128i letter = _mm_and_si128(
+                        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                        _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1))
+                    );
+                    valid = valid && _mm_movemask_epi8(_mm_or_si128(digit, letter)) == 0xffff;
+                    return _mm_or_si128(
+                        _mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                        _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)))
+                    );
+                }
+
+                // Every 16-bit lane holds (high nibble, low nibble), turns it into the byte value in the low half.
+                inline __m128i pack_nibble_pairs_sse2(__m128i nibbles) {
+                    return _mm_or_si128(
+                        _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4),
+                        _mm_srli_epi16(nibbles, 8)
+                    );
+                }
+
+                inline std::size_t decode_sse2(const char* in, std::size_t size, std::uint8_t* out, bool& valid) {
+                    std::size_t i = 0;
+                    for (; i + 16 <= size && valid; i += 16) {
+                        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+                        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 16));
+                        __m128i bytes = _mm_packus_epi16(
+                            pack_nibble_pairs_sse2(ascii_to_nibbles_sse2(first, valid)),
+                            pack_nibble_pairs_sse2(ascii_to_nibbles_sse2(second, valid))
+                        );
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+                    }
+                    return i;
+                }
+
+                __attribute__((target("avx2"))) inline __m256i nibbles_to_ascii_avx2(__m256i nibbles) {
+                    __m256i letters = _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9));
+                    return _mm256_add_epi8(
+                        _mm256_add_epi8(nibbles, _mm256_set1_epi8('0')),
+                        _mm256_and_si256(letters, _mm256_set1_epi8('a' - '0' - 10))
+                    );
+                }
+
+                __attribute__((target("avx2"))) inline std::size_t encode_avx2(
+                    const std::uint8_t* in,
+                    std::size_t size,
+                    char* out
+                ) {
+                    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+                    std::size_t i = 0;
+                    for (; i + 32 <= size; i += 32) {
+                        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                        __m256i high =
+                            nibbles_to_ascii_avx2(_mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_mask));
+                        __m256i low = nibbles_to_ascii_avx2(_mm256_and_si256(bytes, low_mask));
+                        // Unpacking works within 128-bit lanes, put the lanes back in order.
+                        __m256i first = _mm256_unpacklo_epi8(high, low);
+                        __m256i second = _mm256_unpackhi_epi8(high, low);
+                        _mm256_storeu_si256(
+                            reinterpret_cast<__m256i*>(out + 2 * i),
+                            _mm256_permute2x128_si256(first, second, 0x20)
+                        );
+                        _mm256_storeu_si256(
+                            reinterpret_cast<__m256i*>(out + 2 * i + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31)
+                        );
+                    }
+                    return i;
+                }
+
+                __attribute__((target("avx2"))) inline __m256i ascii_to_nibbles_avx2(__m256i chars, bool& valid) {
+                    __m256i digit = _mm256_and_si256(
+                        _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars)
+                    );
+                    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+                    __m256i letter = _mm256_and_si256(
+                        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                        _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower)
+                    );
+                    valid = valid && _mm256_movemask_epi8(_mm256_or_si256(digit, letter)) == -1;
+                    return _mm256_or_si256(
+                        _mm256_and_si256(digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+                        _mm256_and_si256(letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)))
+                    );
+                }
+
+                __attribute__((target("avx2"))) inline __m256i pack_nibble_pairs_avx2(__m256i nibbles) {
+                    return _mm256_or_si256(
+                        _mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00ff)), 4),
+                        _mm256_srli_epi16(nibbles, 8)
+                    );
+                }
+
+                __attribute__((target("avx2"))) inline std::size_t decode_avx2(
+                    const char* in,
+                    std::size_t size,
+                    std::uint8_t* out,
+                    bool& valid
+                ) {
+                    std::size_t i = 0;
+                    for (; i + 32 <= size && valid; i += 32) {
+                        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i));
+                        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i + 32));
+                        __m256i bytes = _mm256_packus_epi16(
+                            pack_nibble_pairs_avx2(ascii_to_nibbles_avx2(first, valid)),
+                            pack_nibble_pairs_avx2(ascii_to_nibbles_avx2(second, valid))
+                        );
+                        // Packing works within 128-bit lanes too.
+                        _mm256_storeu_si256(
+                            reinterpret_cast<__m256i*>(out + i),
+                            _mm256_permute4x64_epi64(bytes, 0xd8)
+                        );
+                    }
+                    return i;
+                }
+
+                inline bool has_avx2() {
+                    static const bool supported = __builtin_cpu_supports("avx2");
+                    return supported;
+                }
+#endif
+            } // namespace detail
+
+            // Writes 2 * size lowercase hex digits to out.
+            inline void encode(const std::uint8_t* in, std::size_t size, char* out) {
+                std::size_t done = 0;
+#ifdef PROOF_GENERATOR_HEX_X86_64
+                done = detail::has_avx2() ? detail::encode_avx2(in, size, out) : 0;
+                done += detail::encode_sse2(in + done, size - done, out + 2 * done);
+#endif
+                detail::encode_scalar(in + done, size - done, out + 2 * done);
+            }
+
+            // Reads 2 * size hex digits of any case into size bytes. Returns false if a non-hex character is met,
+            // out contents are unspecified in this case.
+            inline bool decode(const char* in, std::size_t size, std::uint8_t* out) {
+                std::size_t done = 0;
+#ifdef PROOF_GENERATOR_HEX_X86_64
+                bool valid = true;
+                done = detail::has_avx2() ? detail::decode_avx2(in, size, out, valid) : 0;
+                done += detail::decode_sse2(in + 2 * done, size - done, out + done, valid);
+                if (!valid) {
+                    return false;
+                }
+#endif
+                return detail::decode_scalar(in + 2 * done, size - done, out + done);
+            }
+
+        } // namespace hex
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_HEX_HPP
@@ -0,0 +1,530 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_INDEXED_TABLE_HPP
+#define PROOF_GENERATOR_INDEXED_TABLE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+#include <nil/marshalling/field_type.hpp>
+#include <nil/marshalling/status_type.hpp>
+
+#include <nil/crypto3/marshalling/algebra/types/field_element.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/assignment.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/table_description.hpp>
+
+#include <nil/proof-generator/assignment_table_reader.hpp>
+#include <nil/proof-generator/byte_order.hpp>
+#include <nil/proof-generator/counters.hpp>
+#include <nil/proof-generator/file_sink.hpp>
+#include <nil/proof-generator/parallel.hpp>
+
+// Indexed assignment table, version 2 of the table format. Integers of the header and the index are
+// little-endian:
+//     magic "NILT", u32 version, u64 marshalled field element size, u64 witness, public input, constant and
+//     selector columns amounts, u64 usable rows amount, u64 rows amount, u64 columns amount,
+//     then an index entry for every column: u64 offset, u64 size, u32 encoding, u32 encoding parameter,
+//     then the columns, each one starting at a multiple of column_alignment from the beginning of the file.
+// Columns go in witness, public input, constant, selector order. Cells are either fixed-size marshalled field
+// elements or, for columns of small values, bit-packed integers, so any column can be decoded on its own, straight
+// from a file mapping, without touching the others.
+namespace nil {
+    namespace proof_generator {
+        namespace indexed_table {
+            constexpr std::uint8_t magic[4] = {'N', 'I', 'L', 'T'};
+            constexpr std::uint32_t version = 2;
+            constexpr std::size_t header_size = 4 + 4 + 8 + 6 * 8 + 8;
+            constexpr std::size_t index_entry_size = 8 + 8 + 4 + 4;
+            constexpr std::size_t column_alignment = 4096;
+
+            enum class ColumnEncoding : std::uint32_t {
+                // Marshalled field elements, the parameter is unused.
+                FIELD_ELEMENTS = 0,
+                // Values below 2^64 of parameter bits each, a little-endian bit stream in little-endian u64 words.
+                PACKED = 1
+            };
+
+            constexpr std::uint32_t max_packed_width = 64;
+
+            inline bool is_indexed_table(const std::uint8_t* data, std::size_t size) {
+                return size >= header_size && std::memcmp(data, magic, sizeof(magic)) == 0;
+            }
+
+            inline std::size_t align_up(std::size_t value) {
+                return (value + column_alignment - 1) / column_alignment * column_alignment;
+            }
+
+            inline std::size_t packed_size(std::size_t values_amount, std::uint32_t width) {
+                return (values_amount * width + 63) / 64 * 8;
+            }
+
+            inline std::uint32_t bit_width(std::uint64_t value) {
+                return value == 0 ? 0 : 64 - static_cast<std::uint32_t>(__builtin_clzll(value));
+            }
+
+            // Packs the values into packed_size(amount, width) bytes at out.
+            inline void pack_bits(
+                const std::uint64_t* values,
+                std::size_t amount,
+                std::uint32_t width,
+                std::uint8_t* out
+            ) {
+                std::vector<std::uint64_t> words(packed_size(amount, width) / 8, 0);
+                for (std::size_t i = 0; i < amount && width != 0; ++i) {
+                    std::size_t bit = i * width;
+                    std::size_t word = bit / 64, shift = bit % 64;
+                    words[word] |= values[i] << shift;
+                    if (shift + width > 64) {
+                        words[word + 1] |= values[i] >> (64 - shift);
+                    }
+                }
+                for (std::size_t i = 0; i < words.size(); ++i) {
+                    nil::proof_generator::detail::store_le<std::uint64_t>(out + 8 * i, words[i]);
+                }
+            }
+
+            // Unpacks amount values starting with value first. The loop has no data dependent branches, so that
+            // the compiler vectorizes it.
+            inline void unpack_bits(
+                const std::uint8_t* data,
+                std::size_t size,
+                std::uint32_t width,
+                std::size_t first,
+                std::size_t amount,
+                std::uint64_t* out
+            ) {
+                using nil::proof_generator::detail::load_le;
+                if (width == 0) {
+                    std::fill(out, out + amount, 0);
+                    return;
+                }
+                const std::uint64_t mask = width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+                const std::size_t words_amount = size / 8;
+                for (std::size_t i = 0; i < amount; ++i) {
+                    std::size_t bit = (first + i) * width;
+                    std::size_t word = bit / 64, shift = bit % 64;
+                    std::uint64_t low = load_le<std::uint64_t>(data + 8 * word);
+                    std::uint64_t high = word + 1 < words_amount ? load_le<std::uint64_t>(data + 8 * (word + 1)) : 0;
+                    // Shifting by 64 is undefined, hence the two steps for the high word.
+                    out[i] = ((low >> shift) | ((high << 1) << (63 - shift))) & mask;
+                }
+            }
+        } // namespace indexed_table
+
+        template<typename Endianness, typename FieldType, typename Column>
+        class IndexedTable {
+        public:
+            using AssignmentTable = nil::crypto3::zk::snark::plonk_table<FieldType, Column>;
+            using TableDescription = nil::crypto3::zk::snark::plonk_table_description<FieldType>;
+            using TTypeBase = nil::marshalling::field_type<Endianness>;
+            using ElementMarshalling =
+                nil::crypto3::marshalling::types::field_element<TTypeBase, typename FieldType::value_type>;
+
+            struct ColumnEntry {
+                std::uint64_t offset;
+                std::uint64_t size;
+                indexed_table::ColumnEncoding encoding;
+                std::uint32_t parameter;
+            };
+
+            // Parses the header and the index, the columns are only touched by read_column. The data must outlive
+            // the returned object.
+            static std::optional<IndexedTable> open(const std::uint8_t* data, std::size_t size) {
+                using nil::proof_generator::detail::load_le;
+                if (!indexed_table::is_indexed_table(data, size)) {
+                    BOOST_LOG_TRIVIAL(error) << "Not an indexed assignment table";
+                    return std::nullopt;
+                }
+                if (load_le<std::uint32_t>(data + 4) != indexed_table::version) {
+                    BOOST_LOG_TRIVIAL(error) << "Unsupported indexed assignment table version "
+                                             << load_le<std::uint32_t>(data + 4);
+                    return std::nullopt;
+                }
+                if (load_le<std::uint64_t>(data + 8) != element_size()) {
+                    BOOST_LOG_TRIVIAL(error) << "Indexed assignment table holds " << load_le<std::uint64_t>(data + 8)
+                                             << " byte field elements, expected " << element_size();
+                    return std::nullopt;
+                }
+
+                std::size_t header[6];
+                for (std::size_t i = 0; i < 6; ++i) {
+                    header[i] = load_le<std::uint64_t>(data + 16 + 8 * i);
+                }
+                TableDescription description(header[0], header[1], header[2], header[3], header[4], header[5]);
+                const std::uint64_t columns_amount = load_le<std::uint64_t>(data + 64);
+                // Every amount is checked on its own first, so that neither their sum nor the column sizes below
+                // can wrap around.
+                const std::size_t max_rows_amount =
+                    std::numeric_limits<std::size_t>::max() /
+                    std::max<std::size_t>(element_size(), 2 * indexed_table::max_packed_width);
+                if (header[0] > columns_amount || header[1] > columns_amount || header[2] > columns_amount ||
+                    header[3] > columns_amount ||
+                    columns_amount != header[0] + header[1] + header[2] + header[3] ||
+                    columns_amount > (size - indexed_table::header_size) / indexed_table::index_entry_size ||
+                    description.rows_amount > max_rows_amount) {
+                    BOOST_LOG_TRIVIAL(error) << "Indexed assignment table header is corrupted";
+                    return std::nullopt;
+                }
+
+                std::vector<ColumnEntry> entries(columns_amount);
+                const std::uint8_t* entry_data = data + indexed_table::header_size;
+                for (auto& entry : entries) {
+                    entry.offset = load_le<std::uint64_t>(entry_data);
+                    entry.size = load_le<std::uint64_t>(entry_data + 8);
+                    entry.encoding =
+                        static_cast<indexed_table::ColumnEncoding>(load_le<std::uint32_t>(entry_data + 16));
+                    entry.parameter = load_le<std::uint32_t>(entry_data + 20);
+                    entry_data += indexed_table::index_entry_size;
+
+                    if (entry.offset > size || entry.size > size - entry.offset) {
+                        BOOST_LOG_TRIVIAL(error) << "Indexed assignment table is truncated";
+                        return std::nullopt;
+                    }
+                    bool valid_entry = false;
+                    switch (entry.encoding) {
+                        case indexed_table::ColumnEncoding::FIELD_ELEMENTS:
+                            valid_entry = entry.size == description.rows_amount * element_size();
+                            break;
+                        case indexed_table::ColumnEncoding::PACKED:
+                            valid_entry = entry.parameter <= indexed_table::max_packed_width &&
+                                          entry.size == indexed_table::packed_size(description.rows_amount,
+                                                                                   entry.parameter);
+                            break;
+                    }
+                    if (!valid_entry) {
+                        BOOST_LOG_TRIVIAL(error) << "Indexed assignment table column index is corrupted";
+                        return std::nullopt;
+                    }
+                }
+                return IndexedTable(data, description, std::move(entries));
+            }
+
+            static std::size_t element_size() {
+                return ElementMarshalling().length();
+            }
+
+            const TableDescription& description() const {
+                return description_;
+            }
+
+            const std::vector<ColumnEntry>& columns() const {
+                return entries_;
+            }
+
+            // Column index is the position in witness, public input, constant, selector order.
+            bool read_column(std::size_t index, Column& column) const {
+                const ColumnEntry& entry = entries_[index];
+                const std::uint8_t* column_data = data_ + entry.offset;
+                will_need(column_data, entry.size);
+                PROOF_GENERATOR_COUNT(COLUMNS_DECODED, 1);
+                PROOF_GENERATOR_COUNT(CELLS_DECODED, description_.rows_amount);
+
+                column.resize(description_.rows_amount);
+                if (entry.encoding == indexed_table::ColumnEncoding::PACKED) {
+                    read_packed_column(entry, column_data, column);
+                    return true;
+                }
+                ElementMarshalling marshalled_element;
+                auto read_iter = column_data;
+                for (auto& cell : column) {
+                    if (marshalled_element.read(read_iter, element_size()) != nil::marshalling::status_type::success) {
+                        BOOST_LOG_TRIVIAL(error) << "Unable to decode column " << index << " of the assignment table";
+                        return false;
+                    }
+                    cell = marshalled_element.value();
+                }
+                return true;
+            }
+
+            // Amount of column bytes that reading with the given sections touches.
+            std::size_t sections_size(const TableSections& sections) const {
+                std::size_t result = 0;
+                for_each_column(sections, [&](std::size_t index, std::size_t, std::size_t) {
+                    result += entries_[index].size;
+                });
+                return result;
+            }
+
+            // Decodes the requested sections, the columns are spread over the threads.
+            std::optional<std::pair<TableDescription, AssignmentTable>> read(
+                const TableSections& sections = all_table_sections,
+                std::size_t threads = available_cpus()
+            ) const {
+                struct ColumnTask {
+                    std::size_t index;
+                    std::size_t section;
+                    std::size_t position;
+                };
+                std::vector<Column> section_columns[4];
+                std::vector<ColumnTask> tasks;
+                for_each_column(sections, [&](std::size_t index, std::size_t section, std::size_t position) {
+                    section_columns[section].resize(position + 1);
+                    tasks.push_back({index, section, position});
+                });
+
+                std::atomic<bool> failed {false};
+                run_in_parallel(tasks.size(), threads, [&](std::size_t i) {
+                    const ColumnTask& task = tasks[i];
+                    if (!read_column(task.index, section_columns[task.section][task.position])) {
+                        failed = true;
+                    }
+                });
+                if (failed) {
+                    return std::nullopt;
+                }
+
+                return std::make_pair(
+                    description_,
+                    AssignmentTable(
+                        typename AssignmentTable::private_table_type(std::move(section_columns[0])),
+                        typename AssignmentTable::public_table_type(
+                            std::move(section_columns[1]),
+                            std::move(section_columns[2]),
+                            std::move(section_columns[3])
+                        )
+                    )
+                );
+            }
+
+            // Writes a complete table, columns shorter than rows amount are padded with zeroes. With pack set,
+            // columns with all the values below 2^64 are bit-packed with the width of their largest value.
+            static bool write(
+                const TableDescription& description,
+                const AssignmentTable& table,
+                const std::string& path,
+                bool async = false,
+                bool pack = true,
+                std::size_t threads = available_cpus()
+            ) {
+                using nil::proof_generator::detail::store_le;
+                const std::vector<Column>* sections[4] = {
+                    &table.witnesses(), &table.public_inputs(), &table.constants(), &table.selectors()
+                };
+                const std::size_t section_amounts[4] = {
+                    description.witness_columns,
+                    description.public_input_columns,
+                    description.constant_columns,
+                    description.selector_columns
+                };
+                std::vector<const Column*> columns;
+                for (std::size_t section = 0; section < 4; ++section) {
+                    if (sections[section]->size() != section_amounts[section]) {
+                        BOOST_LOG_TRIVIAL(error) << "Assignment table doesn't match its description, can't write it";
+                        return false;
+                    }
+                    for (const auto& column : *sections[section]) {
+                        columns.push_back(&column);
+                    }
+                }
+
+                const std::size_t rows_amount = description.rows_amount;
+                std::vector<ColumnEntry> entries(columns.size());
+                run_in_parallel(columns.size(), threads, [&](std::size_t i) {
+                    std::optional<std::uint32_t> width = pack ? packed_width(*columns[i]) : std::nullopt;
+                    entries[i].encoding =
+                        width ? indexed_table::ColumnEncoding::PACKED : indexed_table::ColumnEncoding::FIELD_ELEMENTS;
+                    entries[i].parameter = width.value_or(0);
+                    entries[i].size = width ? indexed_table::packed_size(rows_amount, *width)
+                                            : rows_amount * element_size();
+                });
+
+                const std::size_t index_end =
+                    indexed_table::header_size + columns.size() * indexed_table::index_entry_size;
+                const std::size_t first_offset = indexed_table::align_up(index_end);
+                std::vector<std::uint8_t> header(first_offset, 0);
+                std::memcpy(header.data(), indexed_table::magic, sizeof(indexed_table::magic));
+                store_le<std::uint32_t>(header.data() + 4, indexed_table::version);
+                store_le<std::uint64_t>(header.data() + 8, element_size());
+                const std::size_t description_values[6] = {
+                    description.witness_columns,
+                    description.public_input_columns,
+                    description.constant_columns,
+                    description.selector_columns,
+                    description.usable_rows_amount,
+                    description.rows_amount
+                };
+                for (std::size_t i = 0; i < 6; ++i) {
+                    store_le<std::uint64_t>(header.data() + 16 + 8 * i, description_values[i]);
+                }
+                store_le<std::uint64_t>(header.data() + 64, columns.size());
+                std::uint8_t* entry_data = header.data() + indexed_table::header_size;
+                std::size_t offset = first_offset;
+                std::size_t packed_columns = 0;
+                for (auto& entry : entries) {
+                    entry.offset = offset;
+                    store_le<std::uint64_t>(entry_data, entry.offset);
+                    store_le<std::uint64_t>(entry_data + 8, entry.size);
+                    store_le<std::uint32_t>(entry_data + 16, static_cast<std::uint32_t>(entry.encoding));
+                    store_le<std::uint32_t>(entry_data + 20, entry.parameter);
+                    entry_data += indexed_table::index_entry_size;
+                    offset += indexed_table::align_up(entry.size);
+                    packed_columns += entry.encoding == indexed_table::ColumnEncoding::PACKED;
+                }
+
+                auto sink = FileSink::open(path, async);
+                if (!sink) {
+                    return false;
+                }
+                sink->write(reinterpret_cast<const char*>(header.data()), header.size());
+
+                std::vector<std::uint8_t> buffer;
+                std::vector<std::uint64_t> values;
+                const typename FieldType::value_type zero = FieldType::value_type::zero();
+                for (std::size_t i = 0; i < columns.size(); ++i) {
+                    const Column& column = *columns[i];
+                    const ColumnEntry& entry = entries[i];
+                    buffer.assign(indexed_table::align_up(entry.size), 0);
+                    PROOF_GENERATOR_COUNT(CELLS_ENCODED, rows_amount);
+                    if (entry.encoding == indexed_table::ColumnEncoding::PACKED) {
+                        values.assign(rows_amount, 0);
+                        for (std::size_t row = 0; row < column.size() && row < rows_amount; ++row) {
+                            values[row] = *to_uint64(column[row]);
+                        }
+                        indexed_table::pack_bits(values.data(), rows_amount, entry.parameter, buffer.data());
+                    } else {
+                        auto write_iter = buffer.begin();
+                        for (std::size_t row = 0; row < rows_amount; ++row) {
+                            ElementMarshalling marshalled_value(row < column.size() ? column[row] : zero);
+                            marshalled_value.write(write_iter, element_size());
+                        }
+                    }
+                    sink->write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+                }
+                BOOST_LOG_TRIVIAL(info) << packed_columns << " of " << columns.size()
+                                        << " assignment table columns are bit-packed, table takes " << offset
+                                        << " bytes instead of " << first_offset + columns.size() *
+                                               indexed_table::align_up(rows_amount * element_size());
+                return sink->close();
+            }
+
+        private:
+            IndexedTable(
+                const std::uint8_t* data,
+                const TableDescription& description,
+                std::vector<ColumnEntry> entries
+            )
+                : data_(data)
+                , description_(description)
+                , entries_(std::move(entries)) {
+            }
+
+            // Calls task(column index, section, position in the section) for the columns of the requested sections.
+            template<typename Task>
+            void for_each_column(const TableSections& sections, Task&& task) const {
+                const bool wanted[4] = {
+                    sections.witnesses, sections.public_inputs, sections.constants, sections.selectors
+                };
+                const std::size_t amounts[4] = {
+                    description_.witness_columns,
+                    description_.public_input_columns,
+                    description_.constant_columns,
+                    description_.selector_columns
+                };
+                std::size_t index = 0;
+                for (std::size_t section = 0; section < 4; ++section) {
+                    for (std::size_t position = 0; position < amounts[section]; ++position, ++index) {
+                        if (wanted[section]) {
+                            task(index, section, position);
+                        }
+                    }
+                }
+            }
+
+            static std::optional<std::uint64_t> to_uint64(const typename FieldType::value_type& value) {
+                using IntegralType = typename FieldType::integral_type;
+                static const IntegralType max_value = IntegralType(std::numeric_limits<std::uint64_t>::max());
+                IntegralType integral_value = IntegralType(value.data);
+                if (integral_value > max_value) {
+                    return std::nullopt;
+                }
+                return static_cast<std::uint64_t>(integral_value);
+            }
+
+            // Width of the largest value of the column, nullopt if some value doesn't fit into 64 bits.
+            static std::optional<std::uint32_t> packed_width(const Column& column) {
+                std::uint64_t all_bits = 0;
+                for (const auto& cell : column) {
+                    auto value = to_uint64(cell);
+                    if (!value) {
+                        return std::nullopt;
+                    }
+                    all_bits |= *value;
+                }
+                return indexed_table::bit_width(all_bits);
+            }
+
+            // Values are unpacked by blocks, the narrow columns (bits, bytes) are mapped to field elements by a
+            // lookup table instead of a conversion per cell.
+            void read_packed_column(const ColumnEntry& entry, const std::uint8_t* data, Column& column) const {
+                using ValueType = typename FieldType::value_type;
+                using IntegralType = typename FieldType::integral_type;
+                constexpr std::uint32_t max_lookup_width = 8;
+                constexpr std::size_t block_size = 1024;
+
+                std::vector<ValueType> lookup;
+                if (entry.parameter <= max_lookup_width) {
+                    lookup.resize(std::size_t(1) << entry.parameter);
+                    for (std::size_t value = 0; value < lookup.size(); ++value) {
+                        lookup[value] = ValueType(IntegralType(value));
+                    }
+                }
+
+                std::uint64_t block[block_size];
+                for (std::size_t first = 0; first < column.size(); first += block_size) {
+                    std::size_t amount = std::min(block_size, column.size() - first);
+                    indexed_table::unpack_bits(data, entry.size, entry.parameter, first, amount, block);
+                    if (!lookup.empty()) {
+                        for (std::size_t i = 0; i < amount; ++i) {
+                            column[first + i] = lookup[block[i]];
+                        }
+                    } else {
+                        for (std::size_t i = 0; i < amount; ++i) {
+                            column[first + i] = ValueType(IntegralType(block[i]));
+                        }
+                    }
+                }
+            }
+
+            // Starts reading the column in, the mapping is not populated when only some of the columns are needed.
+            static void will_need(const std::uint8_t* data, std::size_t size) {
+                static const std::uintptr_t page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+                std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(data) / page_size * page_size;
+                std::uintptr_t end = reinterpret_cast<std::uintptr_t>(data) + size;
+                ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+            }
+
+            const std::uint8_t* data_;
+            TableDescription description_;
+            std::vector<ColumnEntry> entries_;
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_INDEXED_TABLE_HPP
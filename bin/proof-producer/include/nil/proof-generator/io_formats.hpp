@@ -0,0 +1,70 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_IO_FORMATS_HPP
+#define PROOF_GENERATOR_IO_FORMATS_HPP
+
+#include <iostream>
+#include <string>
+
+namespace nil {
+    namespace proof_generator {
+
+        // On-disk encoding of the proof file.
+        enum class ProofFormat {
+            HEX = 0,
+            BINARY = 1
+        };
+
+        inline std::ostream& operator<<(std::ostream& strm, const ProofFormat& format) {
+            switch (format) {
+                case ProofFormat::HEX:
+                    return strm << "hex";
+                case ProofFormat::BINARY:
+                    return strm << "binary";
+            }
+            strm.setstate(std::ios_base::failbit);
+            return strm;
+        }
+
+        inline std::istream& operator>>(std::istream& strm, ProofFormat& format) {
+            std::string str;
+            strm >> str;
+            if (str == "hex") {
+                format = ProofFormat::HEX;
+            } else if (str == "binary") {
+                format = ProofFormat::BINARY;
+            } else {
+                strm.setstate(std::ios_base::failbit);
+            }
+            return strm;
+        }
+
+        // How the prover writes its output files.
+        struct OutputOptions {
+            ProofFormat proof_format = ProofFormat::HEX;
+            // Skip the JSON proof for the EVM verifier.
+            bool write_json = true;
+            // Write the files from a background thread, overlapping encoding with the disk writes.
+            bool async_write = false;
+            // zstd level for the preprocessed data and commitment scheme state, 0 writes them uncompressed.
+            int compression_level = 0;
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_IO_FORMATS_HPP
@@ -0,0 +1,41 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_MEMORY_BUDGET_HPP
+#define PROOF_GENERATOR_MEMORY_BUDGET_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace nil {
+    namespace proof_generator {
+
+        // Once the anonymous resident memory of the process would grow over limit_bytes, allocations of a MiB and
+        // more through operator new (polynomials, columns, commitment trees) are placed into a memory-mapped scratch
+        // file in scratch_dir instead. The kernel writes such pages back to the file under memory pressure and reads
+        // them back in on access, so the prover gets slower instead of being OOM-killed. scratch_dir must be on disk,
+        // tmpfs and ramfs are rejected. Must be called once, before the large data is allocated.
+        bool enable_memory_budget(std::size_t limit_bytes, const std::string& scratch_dir);
+
+        // Anonymous resident memory of the process, and bytes currently or at most placed in the scratch file.
+        std::size_t heap_bytes_in_use();
+        std::size_t spilled_bytes_in_use();
+        std::size_t spilled_bytes_peak();
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_MEMORY_BUDGET_HPP
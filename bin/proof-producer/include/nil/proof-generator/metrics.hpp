@@ -0,0 +1,426 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_METRICS_HPP
+#define PROOF_GENERATOR_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+
+namespace nil {
+    namespace proof_generator {
+        namespace detail {
+            inline double process_cpu_seconds() {
+                timespec ts;
+                if (::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+                    return 0;
+                }
+                return ts.tv_sec + ts.tv_nsec * 1e-9;
+            }
+
+            inline std::uint64_t peak_rss_bytes() {
+                rusage usage;
+                if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+                    return 0;
+                }
+                // Linux reports kilobytes.
+                return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+            }
+
+            inline std::string json_escape(const std::string& str) {
+                std::string result;
+                result.reserve(str.size());
+                for (char c : str) {
+                    switch (c) {
+                        case '"':
+                            result += "\\\"";
+                            break;
+                        case '\\':
+                            result += "\\\\";
+                            break;
+                        case '\n':
+                            result += "\\n";
+                            break;
+                        default:
+                            if (static_cast<unsigned char>(c) < 0x20) {
+                                char escaped[7];
+                                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                                result += escaped;
+                            } else {
+                                result += c;
+                            }
+                    }
+                }
+                return result;
+            }
+        } // namespace detail
+
+        // Process-wide collection of per-step resource usage, written as JSON for job schedulers.
+        // CPU time and peak RSS are process-wide, steps run concurrently are combined into one with ConcurrentSteps.
+        class Metrics {
+        public:
+            struct Step {
+                std::string name;
+                double start_seconds;
+                double wall_seconds;
+                double cpu_seconds;
+                std::uint64_t peak_rss_bytes;
+                std::uint64_t peak_rss_delta_bytes;
+                std::uint64_t bytes_read;
+                std::uint64_t bytes_written;
+            };
+
+            static Metrics& instance() {
+                static Metrics metrics;
+                return metrics;
+            }
+
+            void add_bytes_read(std::uint64_t bytes) {
+                bytes_read_.fetch_add(bytes, std::memory_order_relaxed);
+            }
+
+            void add_bytes_written(std::uint64_t bytes) {
+                bytes_written_.fetch_add(bytes, std::memory_order_relaxed);
+            }
+
+            std::uint64_t bytes_read() const {
+                return bytes_read_.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t bytes_written() const {
+                return bytes_written_.load(std::memory_order_relaxed);
+            }
+
+            double seconds_since_start() const {
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+            }
+
+            // Steps started while concurrent steps are combined are recorded as trace spans only, their resource
+            // usage is accounted to the enclosing step.
+            void begin_concurrent_steps() {
+                concurrent_sections_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void end_concurrent_steps() {
+                concurrent_sections_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            bool records_steps() const {
+                return concurrent_sections_.load(std::memory_order_relaxed) == 0;
+            }
+
+            void add_step(Step step) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                steps_.push_back(std::move(step));
+            }
+
+            // Free-form facts about the run, e.g. the parameters that were in effect.
+            void set_info(const std::string& key, const std::string& value) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                info_[key] = value;
+            }
+
+            bool write_json(const boost::filesystem::path& path, bool success) const {
+                std::ostringstream out;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    out << "{\n";
+                    out << "  \"success\": " << (success ? "true" : "false") << ",\n";
+                    out << "  \"wall_seconds\": " << seconds_since_start() << ",\n";
+                    out << "  \"cpu_seconds\": " << detail::process_cpu_seconds() << ",\n";
+                    out << "  \"peak_rss_bytes\": " << detail::peak_rss_bytes() << ",\n";
+                    out << "  \"bytes_read\": " << bytes_read() << ",\n";
+                    out << "  \"bytes_written\": " << bytes_written() << ",\n";
+                    out << "  \"info\": {";
+                    const char* separator = "\n";
+                    for (const auto& [key, value] : info_) {
+                        out << separator << "    \"" << detail::json_escape(key) << "\": \""
+                            << detail::json_escape(value) << "\"";
+                        separator = ",\n";
+                    }
+                    out << "\n  },\n";
+                    out << "  \"steps\": [";
+                    separator = "\n";
+                    for (const auto& step : steps_) {
+                        out << separator << "    {\"name\": \"" << detail::json_escape(step.name) << "\""
+                            << ", \"start_seconds\": " << step.start_seconds
+                            << ", \"wall_seconds\": " << step.wall_seconds
+                            << ", \"cpu_seconds\": " << step.cpu_seconds
+                            << ", \"peak_rss_bytes\": " << step.peak_rss_bytes
+                            << ", \"peak_rss_delta_bytes\": " << step.peak_rss_delta_bytes
+                            << ", \"bytes_read\": " << step.bytes_read
+                            << ", \"bytes_written\": " << step.bytes_written << "}";
+                        separator = ",\n";
+                    }
+                    out << "\n  ]\n}\n";
+                }
+
+                std::ofstream file(path.string(), std::ios_base::out | std::ios_base::trunc);
+                file << out.str();
+                if (!file) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to write metrics to " << path;
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            Metrics()
+                : start_(std::chrono::steady_clock::now()) {
+            }
+
+            const std::chrono::steady_clock::time_point start_;
+            std::atomic<std::uint64_t> bytes_read_ {0};
+            std::atomic<std::uint64_t> bytes_written_ {0};
+            std::atomic<std::size_t> concurrent_sections_ {0};
+
+            mutable std::mutex mutex_;
+            std::vector<Step> steps_;
+            std::map<std::string, std::string> info_;
+        };
+
+        // Process-wide recorder of time spans, written in Chrome trace event format for Perfetto or
+        // chrome://tracing. Disabled unless enabled at start, then spans cost nothing but a flag check.
+        class Tracer {
+        public:
+            struct Span {
+                std::string name;
+                const char* category;
+                std::string detail;
+                double start_microseconds;
+                double duration_microseconds;
+                long thread_id;
+            };
+
+            static Tracer& instance() {
+                static Tracer tracer;
+                return tracer;
+            }
+
+            void enable() {
+                enabled_.store(true, std::memory_order_relaxed);
+            }
+
+            bool enabled() const {
+                return enabled_.load(std::memory_order_relaxed);
+            }
+
+            double microseconds_since_start() const {
+                return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_).count();
+            }
+
+            static long current_thread_id() {
+                thread_local const long thread_id = ::syscall(SYS_gettid);
+                return thread_id;
+            }
+
+            void add_span(Span span) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (spans_.size() >= max_spans) {
+                    ++dropped_spans_;
+                    return;
+                }
+                spans_.push_back(std::move(span));
+            }
+
+            bool write_chrome_trace(const boost::filesystem::path& path) const {
+                const long process_id = ::getpid();
+                std::ostringstream out;
+                out << std::fixed << std::setprecision(3);
+                out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+                out << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << process_id
+                    << ", \"tid\": " << process_id << ", \"args\": {\"name\": \"main\"}}";
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (const auto& span : spans_) {
+                        out << ",\n  {\"name\": \"" << detail::json_escape(span.name) << "\", \"cat\": \""
+                            << span.category << "\", \"ph\": \"X\", \"ts\": " << span.start_microseconds
+                            << ", \"dur\": " << span.duration_microseconds << ", \"pid\": " << process_id
+                            << ", \"tid\": " << span.thread_id;
+                        if (!span.detail.empty()) {
+                            out << ", \"args\": {\"detail\": \"" << detail::json_escape(span.detail) << "\"}";
+                        }
+                        out << "}";
+                    }
+                }
+                out << "\n]}\n";
+                if (dropped_spans_ != 0) {
+                    BOOST_LOG_TRIVIAL(warning) << "Trace holds the first " << max_spans << " spans, "
+                                               << dropped_spans_ << " later ones were dropped";
+                }
+
+                std::ofstream file(path.string(), std::ios_base::out | std::ios_base::trunc);
+                file << out.str();
+                if (!file) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to write trace to " << path;
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            // Long running stages, like serve, would otherwise grow the trace without bound.
+            static constexpr std::size_t max_spans = std::size_t(1) << 20;
+
+            Tracer()
+                : start_(std::chrono::steady_clock::now()) {
+            }
+
+            const std::chrono::steady_clock::time_point start_;
+            std::atomic<bool> enabled_ {false};
+
+            mutable std::mutex mutex_;
+            std::vector<Span> spans_;
+            std::size_t dropped_spans_ = 0;
+        };
+
+        // Records the enclosing scope as a trace span when tracing is enabled.
+        class TraceSpan {
+        public:
+            // Names are copied only when tracing is enabled.
+            TraceSpan(const char* category, std::string_view name, std::string_view detail = {})
+                : active_(Tracer::instance().enabled()) {
+                if (active_) {
+                    name_ = name;
+                    category_ = category;
+                    detail_ = detail;
+                    start_microseconds_ = Tracer::instance().microseconds_since_start();
+                }
+            }
+            TraceSpan(const TraceSpan&) = delete;
+            TraceSpan& operator=(const TraceSpan&) = delete;
+
+            ~TraceSpan() {
+                finish();
+            }
+
+            void finish() {
+                if (!active_) {
+                    return;
+                }
+                active_ = false;
+                Tracer& tracer = Tracer::instance();
+                tracer.add_span({
+                    std::move(name_),
+                    category_,
+                    std::move(detail_),
+                    start_microseconds_,
+                    tracer.microseconds_since_start() - start_microseconds_,
+                    Tracer::current_thread_id()
+                });
+            }
+
+        private:
+            bool active_;
+            std::string name_;
+            const char* category_ = nullptr;
+            std::string detail_;
+            double start_microseconds_ = 0;
+        };
+
+        // Records resource usage of the enclosing scope as a step named `name`, and as a trace span.
+        class ScopedStep {
+        public:
+            explicit ScopedStep(std::string name)
+                : span_("step", name)
+                , name_(std::move(name))
+                , start_seconds_(Metrics::instance().seconds_since_start())
+                , start_cpu_seconds_(detail::process_cpu_seconds())
+                , start_peak_rss_(detail::peak_rss_bytes())
+                , start_bytes_read_(Metrics::instance().bytes_read())
+                , start_bytes_written_(Metrics::instance().bytes_written())
+                , recorded_(Metrics::instance().records_steps()) {
+            }
+            ScopedStep(const ScopedStep&) = delete;
+            ScopedStep& operator=(const ScopedStep&) = delete;
+
+            ~ScopedStep() {
+                finish();
+            }
+
+            // Ends the step before the end of the scope.
+            void finish() {
+                if (finished_) {
+                    return;
+                }
+                finished_ = true;
+                span_.finish();
+                if (!recorded_) {
+                    return;
+                }
+                Metrics& metrics = Metrics::instance();
+                std::uint64_t peak_rss = detail::peak_rss_bytes();
+                metrics.add_step({
+                    std::move(name_),
+                    start_seconds_,
+                    metrics.seconds_since_start() - start_seconds_,
+                    detail::process_cpu_seconds() - start_cpu_seconds_,
+                    peak_rss,
+                    peak_rss - start_peak_rss_,
+                    metrics.bytes_read() - start_bytes_read_,
+                    metrics.bytes_written() - start_bytes_written_
+                });
+            }
+
+        private:
+            TraceSpan span_;
+            std::string name_;
+            const double start_seconds_;
+            const double start_cpu_seconds_;
+            const std::uint64_t start_peak_rss_;
+            const std::uint64_t start_bytes_read_;
+            const std::uint64_t start_bytes_written_;
+            const bool recorded_;
+            bool finished_ = false;
+        };
+
+        // Combines the steps run concurrently within its scope into the enclosing step. CPU time, RSS and I/O are
+        // process-wide, so steps of their own would each account the usage of all the others.
+        class ConcurrentSteps {
+        public:
+            ConcurrentSteps() {
+                Metrics::instance().begin_concurrent_steps();
+            }
+            ConcurrentSteps(const ConcurrentSteps&) = delete;
+            ConcurrentSteps& operator=(const ConcurrentSteps&) = delete;
+
+            ~ConcurrentSteps() {
+                Metrics::instance().end_concurrent_steps();
+            }
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_METRICS_HPP
@@ -0,0 +1,101 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_PARALLEL_HPP
+#define PROOF_GENERATOR_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+
+namespace nil {
+    namespace proof_generator {
+
+        // CPUs the process is allowed to run on, which --cpus and --cpu-affinity restrict. Unlike
+        // std::thread::hardware_concurrency() it follows the affinity mask, so the pools don't oversubscribe the CPUs.
+        inline std::size_t available_cpus() {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (::sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+                return static_cast<std::size_t>(CPU_COUNT(&set));
+            }
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Calls task(i) for every i in [0, tasks_amount) on at most max_concurrency threads, the calling one
+        // included. Tasks are picked in index order. The first exception thrown by a task is rethrown once all
+        // the threads are done, the tasks not started by then are skipped.
+        template<typename Task>
+        void run_in_parallel(std::size_t tasks_amount, std::size_t max_concurrency, Task&& task) {
+            std::atomic<std::size_t> next_task {0};
+            std::atomic<bool> failed {false};
+            std::exception_ptr exception;
+            std::mutex exception_mutex;
+
+            auto worker = [&]() {
+                for (std::size_t i = next_task++; i < tasks_amount && !failed; i = next_task++) {
+                    try {
+                        task(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(exception_mutex);
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                        failed = true;
+                    }
+                }
+            };
+
+            std::size_t threads_amount = std::min(std::max<std::size_t>(max_concurrency, 1), tasks_amount);
+            std::vector<std::thread> threads;
+            for (std::size_t i = 1; i < threads_amount; ++i) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        // Runs bool-returning tasks, such as loads of independent inputs, on at most max_concurrency threads.
+        // All the tasks run to completion, the result tells whether every one of them succeeded.
+        template<typename... Tasks>
+        bool all_of_concurrently(std::size_t max_concurrency, Tasks&&... tasks) {
+            std::function<bool()> functions[] = {std::function<bool()>(std::forward<Tasks>(tasks))...};
+            std::atomic<bool> succeeded {true};
+            run_in_parallel(sizeof...(Tasks), max_concurrency, [&](std::size_t i) {
+                if (!functions[i]()) {
+                    succeeded = false;
+                }
+            });
+            return succeeded;
+        }
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_PARALLEL_HPP
@@ -0,0 +1,179 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_PREPROCESS_CACHE_HPP
+#define PROOF_GENERATOR_PREPROCESS_CACHE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+
+namespace nil {
+    namespace proof_generator {
+
+        // On-disk cache of public preprocessor outputs, shared by the producers running on one host.
+        // Every entry is a directory named by the key, it is staged under a unique name and renamed into place,
+        // so an entry is either complete or not visible at all. Entries are evicted least recently used first
+        // once the total size goes over the limit.
+        class PreprocessCache {
+        public:
+            static constexpr const char* preprocessed_data_file = "preprocessed_data.dat";
+            static constexpr const char* commitment_scheme_state_file = "commitment_scheme_state.dat";
+
+            // max_size = 0 disables eviction.
+            PreprocessCache(boost::filesystem::path directory, std::uintmax_t max_size)
+                : directory_(std::move(directory))
+                , max_size_(max_size) {
+            }
+
+            // Returns directory of the complete entry, if any, and marks it as recently used.
+            std::optional<boost::filesystem::path> lookup(const std::string& key) const {
+                boost::filesystem::path entry = directory_ / key;
+                boost::system::error_code ec;
+                if (!boost::filesystem::is_directory(entry, ec)) {
+                    return std::nullopt;
+                }
+                boost::filesystem::last_write_time(entry, std::time(nullptr), ec);
+                return entry;
+            }
+
+            // Creates an empty staging directory to write a new entry into.
+            std::optional<boost::filesystem::path> begin_insert(const std::string& key) const {
+                boost::system::error_code ec;
+                boost::filesystem::create_directories(directory_, ec);
+                boost::filesystem::path staging = directory_ / (staging_prefix + key + "-" + unique_suffix());
+                if (!boost::filesystem::create_directory(staging, ec)) {
+                    BOOST_LOG_TRIVIAL(warning) << "Unable to create cache staging directory " << staging << ": "
+                                               << ec.message();
+                    return std::nullopt;
+                }
+                return staging;
+            }
+
+            // Publishes the staged entry. If the entry was published by someone else in the meantime, theirs is kept.
+            void commit_insert(const boost::filesystem::path& staging, const std::string& key) const {
+                boost::filesystem::path entry = directory_ / key;
+                if (std::rename(staging.c_str(), entry.c_str()) != 0) {
+                    if (errno != EEXIST && errno != ENOTEMPTY) {
+                        BOOST_LOG_TRIVIAL(warning) << "Unable to publish cache entry " << entry << ": "
+                                                   << std::strerror(errno);
+                    }
+                    abandon_insert(staging);
+                    return;
+                }
+                BOOST_LOG_TRIVIAL(info) << "Preprocessed data cached in " << entry;
+                evict();
+            }
+
+            void abandon_insert(const boost::filesystem::path& staging) const {
+                boost::system::error_code ec;
+                boost::filesystem::remove_all(staging, ec);
+            }
+
+            // Removes least recently used entries until the cache fits into max size, and staging directories
+            // abandoned by crashed producers.
+            void evict() const {
+                if (max_size_ == 0) {
+                    return;
+                }
+
+                struct Entry {
+                    boost::filesystem::path path;
+                    std::time_t last_used;
+                    std::uintmax_t size;
+                };
+                std::vector<Entry> entries;
+                std::uintmax_t total_size = 0;
+                const std::time_t now = std::time(nullptr);
+
+                boost::system::error_code ec;
+                for (boost::filesystem::directory_iterator it(directory_, ec), end; !ec && it != end;
+                     it.increment(ec)) {
+                    const boost::filesystem::path& path = it->path();
+                    std::time_t last_used = boost::filesystem::last_write_time(path, ec);
+                    if (ec) {
+                        ec.clear();
+                        continue;
+                    }
+                    if (path.filename().string().rfind(staging_prefix, 0) == 0) {
+                        if (now - last_used > stale_staging_age) {
+                            abandon_insert(path);
+                        }
+                        continue;
+                    }
+                    std::uintmax_t size = directory_size(path);
+                    total_size += size;
+                    entries.push_back({path, last_used, size});
+                }
+
+                std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+                    return lhs.last_used < rhs.last_used;
+                });
+                for (const auto& entry : entries) {
+                    if (total_size <= max_size_) {
+                        break;
+                    }
+                    // Move the entry out of sight first, so nobody picks up a half removed one.
+                    boost::filesystem::path doomed = directory_ / (std::string(staging_prefix) + "evicted-" + unique_suffix());
+                    if (std::rename(entry.path.c_str(), doomed.c_str()) == 0) {
+                        BOOST_LOG_TRIVIAL(info) << "Evicting " << entry.path << " from preprocess cache";
+                        abandon_insert(doomed);
+                    }
+                    total_size -= entry.size;
+                }
+            }
+
+        private:
+            static constexpr const char* staging_prefix = ".staging-";
+            // Staging directories older than this are considered left by crashed producers.
+            static constexpr std::time_t stale_staging_age = 24 * 60 * 60;
+
+            static std::string unique_suffix() {
+                static thread_local std::mt19937_64 generator(std::random_device {}());
+                return std::to_string(::getpid()) + "-" + std::to_string(generator());
+            }
+
+            static std::uintmax_t directory_size(const boost::filesystem::path& path) {
+                std::uintmax_t size = 0;
+                boost::system::error_code ec;
+                for (boost::filesystem::recursive_directory_iterator it(path, ec), end; !ec && it != end;
+                     it.increment(ec)) {
+                    if (boost::filesystem::is_regular_file(it->path(), ec)) {
+                        size += boost::filesystem::file_size(it->path(), ec);
+                    }
+                }
+                return size;
+            }
+
+            boost::filesystem::path directory_;
+            std::uintmax_t max_size_;
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_PREPROCESS_CACHE_HPP
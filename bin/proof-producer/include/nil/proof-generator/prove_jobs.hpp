@@ -0,0 +1,96 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_PROVE_JOBS_HPP
+#define PROOF_GENERATOR_PROVE_JOBS_HPP
+
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+
+namespace nil {
+    namespace proof_generator {
+
+        // One assignment table to be proven against an already preprocessed circuit.
+        struct ProveJob {
+            boost::filesystem::path assignment_table_file_path;
+            boost::filesystem::path proof_file_path;
+            boost::filesystem::path json_file_path;
+        };
+
+        // Parses a job line of form "<assignment-table> <proof> [<json-proof>]". Paths are separated by
+        // whitespace. JSON proof path defaults to the proof path with ".json" extension.
+        inline std::optional<ProveJob> parse_prove_job(const std::string& line) {
+            std::istringstream stream(line);
+            std::string assignment_table, proof, json;
+            if (!(stream >> assignment_table >> proof)) {
+                BOOST_LOG_TRIVIAL(error) << "Malformed prove job \"" << line
+                                         << "\", expected \"<assignment-table> <proof> [<json-proof>]\"";
+                return std::nullopt;
+            }
+            stream >> json;
+            std::string rest;
+            if (stream >> rest) {
+                BOOST_LOG_TRIVIAL(error) << "Malformed prove job \"" << line << "\", too many fields";
+                return std::nullopt;
+            }
+
+            ProveJob job;
+            job.assignment_table_file_path = assignment_table;
+            job.proof_file_path = proof;
+            job.json_file_path = json.empty() ? boost::filesystem::path(proof).replace_extension(".json")
+                                              : boost::filesystem::path(json);
+            return job;
+        }
+
+        // Reads a manifest with one job per line, see parse_prove_job. Empty lines and lines starting with '#'
+        // are skipped.
+        inline std::optional<std::vector<ProveJob>> read_prove_jobs_manifest(const boost::filesystem::path& path) {
+            std::ifstream stream(path.string());
+            if (!stream.is_open()) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to open file: " << path;
+                return std::nullopt;
+            }
+
+            std::vector<ProveJob> jobs;
+            std::string line;
+            while (std::getline(stream, line)) {
+                auto first = line.find_first_not_of(" \t\r");
+                if (first == std::string::npos || line[first] == '#') {
+                    continue;
+                }
+                auto job = parse_prove_job(line);
+                if (!job) {
+                    return std::nullopt;
+                }
+                jobs.push_back(std::move(*job));
+            }
+            if (jobs.empty()) {
+                BOOST_LOG_TRIVIAL(error) << "No prove jobs in " << path;
+                return std::nullopt;
+            }
+            return jobs;
+        }
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_PROVE_JOBS_HPP
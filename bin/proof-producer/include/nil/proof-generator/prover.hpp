@@ -20,9 +20,16 @@
 #ifndef PROOF_GENERATOR_ASSIGNER_PROOF_HPP
 #define PROOF_GENERATOR_ASSIGNER_PROOF_HPP
 
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
 #include <random>
 #include <sstream>
+#include <typeinfo>
 
 #include <boost/log/trivial.hpp>
 
@@ -40,6 +47,7 @@
 #include <nil/crypto3/marshalling/zk/types/plonk/constraint_system.hpp>
 
 #include <nil/crypto3/math/algorithms/calculate_domain_set.hpp>
+#include <nil/crypto3/math/polynomial/polynomial_dfs.hpp>
 
 #include <nil/crypto3/zk/snark/arithmetization/plonk/constraint_system.hpp>
 #include <nil/crypto3/zk/snark/arithmetization/plonk/params.hpp>
@@ -52,51 +60,126 @@
 #include <nil/crypto3/zk/snark/systems/plonk/placeholder/verifier.hpp>
 #include <nil/crypto3/zk/transcript/fiat_shamir.hpp>
 
+#include <nil/crypto3/hash/algorithm/hash.hpp>
+
 #include <nil/blueprint/transpiler/recursive_verifier_generator.hpp>
 
 
 #include <nil/proof-generator/arithmetization_params.hpp>
+#include <nil/proof-generator/assignment_table_reader.hpp>
+#include <nil/proof-generator/compression.hpp>
+#include <nil/proof-generator/cost_model.hpp>
+#include <nil/proof-generator/counters.hpp>
 #include <nil/proof-generator/file_operations.hpp>
+#include <nil/proof-generator/indexed_table.hpp>
+#include <nil/proof-generator/io_formats.hpp>
+#include <nil/proof-generator/metrics.hpp>
+#include <nil/proof-generator/parallel.hpp>
+#include <nil/proof-generator/preprocess_cache.hpp>
 
 namespace nil {
     namespace proof_generator {
         namespace detail {
             template<typename MarshallingType>
-            std::optional<MarshallingType> decode_marshalling_from_file(
-                const boost::filesystem::path& path,
-                bool hex = false
+            std::optional<MarshallingType> decode_marshalling(
+                const std::uint8_t* data,
+                std::size_t size,
+                const boost::filesystem::path& path
             ) {
-                const auto v = hex ? read_hex_file_to_vector(path.c_str()) : read_file_to_vector(path.c_str());
-                if (!v.has_value()) {
-                    return std::nullopt;
-                }
-
                 MarshallingType marshalled_data;
-                auto read_iter = v->begin();
-                auto status = marshalled_data.read(read_iter, v->size());
+                auto read_iter = data;
+                auto status = marshalled_data.read(read_iter, size);
                 if (status != nil::marshalling::status_type::success) {
                     BOOST_LOG_TRIVIAL(error) << "When reading a Marshalled structure from file " << path << ", decoding step failed";
                     return std::nullopt;
                 }
+                PROOF_GENERATOR_COUNT(BYTES_UNMARSHALLED, read_iter - data);
                 return marshalled_data;
             }
 
+            // Compressed files are recognized by their header, so readers don't need to be told about them.
             template<typename MarshallingType>
-            bool encode_marshalling_to_file(
+            std::optional<MarshallingType> decode_possibly_compressed(
+                const std::uint8_t* data,
+                std::size_t size,
+                const boost::filesystem::path& path
+            ) {
+                if (!compression::is_compressed(data, size)) {
+                    return decode_marshalling<MarshallingType>(data, size, path);
+                }
+                ScopedStep step("decompress");
+                auto decompressed = compression::decompress(data, size);
+                if (!decompressed) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to decompress " << path;
+                    return std::nullopt;
+                }
+                step.finish();
+                return decode_marshalling<MarshallingType>(decompressed->data(), decompressed->size(), path);
+            }
+
+            template<typename MarshallingType>
+            std::optional<MarshallingType> decode_marshalling_from_file(
                 const boost::filesystem::path& path,
-                const MarshallingType& data_for_marshalling,
                 bool hex = false
             ) {
+                if (hex) {
+                    const auto v = read_hex_file_to_vector(path.string());
+                    if (!v.has_value()) {
+                        return std::nullopt;
+                    }
+                    return decode_marshalling<MarshallingType>(v->data(), v->size(), path);
+                }
+
+                auto input = InputFile::open(path.string());
+                if (!input) {
+                    return std::nullopt;
+                }
+                // Decode straight from the page cache, the mapping is released as soon as decoding is done.
+                auto mapped = input->map();
+                if (mapped.has_value()) {
+                    return decode_possibly_compressed<MarshallingType>(mapped->data(), mapped->size(), path);
+                }
+                const auto v = input->read_to_vector();
+                if (!v.has_value()) {
+                    return std::nullopt;
+                }
+                return decode_possibly_compressed<MarshallingType>(v->data(), v->size(), path);
+            }
+
+            template<typename MarshallingType>
+            std::optional<std::vector<std::uint8_t>> encode_marshalling(const MarshallingType& data_for_marshalling) {
                 std::vector<std::uint8_t> v;
                 v.resize(data_for_marshalling.length(), 0x00);
                 auto write_iter = v.begin();
                 nil::marshalling::status_type status = data_for_marshalling.write(write_iter, v.size());
                 if (status != nil::marshalling::status_type::success) {
                     BOOST_LOG_TRIVIAL(error) << "Marshalled structure encoding failed";
+                    return std::nullopt;
+                }
+                PROOF_GENERATOR_COUNT(BYTES_MARSHALLED, v.size());
+                return v;
+            }
+
+            template<typename MarshallingType>
+            bool encode_marshalling_to_file(
+                const boost::filesystem::path& path,
+                const MarshallingType& data_for_marshalling,
+                bool hex = false,
+                int compression_level = 0
+            ) {
+                auto v = encode_marshalling(data_for_marshalling);
+                if (!v) {
                     return false;
                 }
+                if (compression_level != 0) {
+                    ScopedStep step("compress");
+                    v = compression::compress(v->data(), v->size(), compression_level);
+                    if (!v) {
+                        return false;
+                    }
+                }
 
-                return hex ? write_vector_to_hex_file(v, path.c_str()) : write_vector_to_file(v, path.c_str());
+                return hex ? write_vector_to_hex_file(*v, path.c_str()) : write_vector_to_file(*v, path.c_str());
             }
 
             enum class ProverStage {
@@ -104,7 +187,11 @@ namespace nil {
                 PREPROCESS = 1,
                 PROVE = 2,
                 VERIFY = 3,
-                GENERATE_AGGREGATED_CHALLENGE = 4
+                GENERATE_AGGREGATED_CHALLENGE = 4,
+                SERVE = 5,
+                PROVE_BATCH = 6,
+                CONVERT_TABLE = 7,
+                ESTIMATE = 8
             };
 
             ProverStage prover_stage_from_string(const std::string& stage) {
@@ -113,7 +200,11 @@ namespace nil {
                     {"preprocess", ProverStage::PREPROCESS},
                     {"prove", ProverStage::PROVE},
                     {"verify", ProverStage::VERIFY},
-                    {"generate-aggregated-challenge", ProverStage::GENERATE_AGGREGATED_CHALLENGE}
+                    {"generate-aggregated-challenge", ProverStage::GENERATE_AGGREGATED_CHALLENGE},
+                    {"serve", ProverStage::SERVE},
+                    {"prove-batch", ProverStage::PROVE_BATCH},
+                    {"convert-table", ProverStage::CONVERT_TABLE},
+                    {"estimate", ProverStage::ESTIMATE}
                 };
                 auto it = stage_map.find(stage);
                 if (it == stage_map.end()) {
@@ -124,6 +215,12 @@ namespace nil {
 
         } // namespace detail
 
+        // Only the multi-threaded executable starts threads of its own to overlap the work on a generated proof.
+#ifdef PROOF_GENERATOR_MULTI_THREADED
+        constexpr std::launch output_launch_policy = std::launch::async;
+#else
+        constexpr std::launch output_launch_policy = std::launch::deferred;
+#endif
 
         template<typename CurveType, typename HashType>
         class Prover {
@@ -152,12 +249,14 @@ namespace nil {
                 std::size_t lambda,
                 std::size_t expand_factor,
                 std::size_t max_q_chunks,
-                std::size_t grind
+                std::size_t grind,
+                const OutputOptions& output_options
             )
                 : lambda_(lambda)
                 , expand_factor_(expand_factor)
                 , max_quotient_chunks_(max_q_chunks)
-                , grind_(grind) {
+                , grind_(grind)
+                , output_options_(output_options) {
             }
 
             // The caller must call the preprocessor or load the preprocessed data before calling this function.
@@ -165,6 +264,7 @@ namespace nil {
                     boost::filesystem::path proof_file_,
                     boost::filesystem::path json_file_,
                     bool skip_verification) {
+                ScopedStep step("generate_to_file");
                 if (!nil::proof_generator::can_write_to_file(proof_file_.string())) {
                     BOOST_LOG_TRIVIAL(error) << "Can't write to file " << proof_file_;
                     return false;
@@ -177,6 +277,7 @@ namespace nil {
                 BOOST_ASSERT(lpc_scheme_);
 
                 BOOST_LOG_TRIVIAL(info) << "Generating proof...";
+                ScopedStep proving_step("placeholder_prover");
                 Proof proof = nil::crypto3::zk::snark::placeholder_prover<BlueprintField, PlaceholderParams>::process(
                     *public_preprocessed_data_,
                     *private_preprocessed_data_,
@@ -184,57 +285,81 @@ namespace nil {
                     *constraint_system_,
                     *lpc_scheme_
                 );
+                proving_step.finish();
+                PROOF_GENERATOR_COUNT(PROOFS_GENERATED, 1);
                 BOOST_LOG_TRIVIAL(info) << "Proof generated";
 
-                if (skip_verification) {
-                    BOOST_LOG_TRIVIAL(info) << "Skipping proof verification";
-                } else {
-                    if (!verify(proof)) {
-                        return false;
+                // Verification, marshalling and JSON generation only read the proof, so the multi-threaded
+                // executable runs them concurrently. The single-threaded one runs them one after another.
+                // Outputs are written to temporary files, which replace the real ones only if the proof is verified.
+                // A proof going to a stream is written once it is verified, as a written one can't be taken back.
+                const FriParams fri_params = lpc_scheme_->get_fri_params();
+                const bool proof_to_stream = is_output_stream(proof_file_.string());
+                const boost::filesystem::path proof_temporary_file = temporary_path_for(proof_file_);
+                const boost::filesystem::path json_temporary_file = temporary_path_for(json_file_);
+
+                auto verification = std::async(output_launch_policy, [this, &proof, skip_verification]() {
+                    if (skip_verification) {
+                        BOOST_LOG_TRIVIAL(info) << "Skipping proof verification";
+                        return true;
+                    }
+                    return verify(proof);
+                });
+                std::optional<std::vector<std::uint8_t>> proof_bytes;
+                auto proof_writing = std::async(
+                    output_launch_policy,
+                    [this, &proof, &fri_params, &proof_bytes, proof_to_stream, &proof_temporary_file]() {
+                        proof_bytes = marshal_proof(proof, fri_params);
+                        if (!proof_bytes) {
+                            return false;
+                        }
+                        return proof_to_stream || write_proof_to_file(*proof_bytes, proof_temporary_file);
                     }
-                }
-
-                BOOST_LOG_TRIVIAL(info) << "Writing proof to " << proof_file_;
-                auto filled_placeholder_proof =
-                    nil::crypto3::marshalling::types::fill_placeholder_proof<Endianness, Proof>(proof, lpc_scheme_->get_fri_params());
-                bool res = nil::proof_generator::detail::encode_marshalling_to_file(
-                    proof_file_,
-                    filled_placeholder_proof,
-                    true
                 );
-                if (res) {
-                    BOOST_LOG_TRIVIAL(info) << "Proof written.";
+                bool json_written = output_options_.write_json && write_json_proof_to_file(proof, json_temporary_file);
+                bool proof_written = proof_writing.get();
+                bool verified = verification.get();
+
+                if (!verified) {
+                    if (!proof_to_stream) {
+                        remove_temporary_file(proof_temporary_file);
+                    }
+                    remove_temporary_file(json_temporary_file);
+                    return false;
+                }
+                if (json_written && commit_temporary_file(json_temporary_file, json_file_)) {
+                    BOOST_LOG_TRIVIAL(info) << "JSON proof written to " << json_file_;
                 } else {
+                    remove_temporary_file(json_temporary_file);
+                }
+                if (proof_to_stream) {
+                    proof_written = proof_written && write_proof_to_file(*proof_bytes, proof_file_);
+                } else if (proof_written) {
+                    proof_written = commit_temporary_file(proof_temporary_file, proof_file_);
+                }
+                if (!proof_written) {
                     BOOST_LOG_TRIVIAL(error) << "Failed to write proof to file.";
+                    if (!proof_to_stream) {
+                        remove_temporary_file(proof_temporary_file);
+                    }
+                    return false;
                 }
-
-                BOOST_LOG_TRIVIAL(info) << "Writing json proof to " << json_file_;
-                auto output_file = open_file<std::ofstream>(json_file_.string(), std::ios_base::out);
-                if (!output_file)
-                    return res;
-
-                (*output_file) << nil::blueprint::recursive_verifier_generator<
-                                      PlaceholderParams,
-                                      nil::crypto3::zk::snark::placeholder_proof<BlueprintField, PlaceholderParams>,
-                                      typename nil::crypto3::zk::snark::placeholder_public_preprocessor<
-                                          BlueprintField,
-                                          PlaceholderParams>::preprocessed_data_type::common_data_type>(
-                                      *table_description_
-                )
-                                      .generate_input(*public_inputs_, proof, constraint_system_->public_input_sizes());
-                output_file->close();
-
-                return res;
+                BOOST_LOG_TRIVIAL(info) << "Proof written to " << proof_file_;
+                return true;
             }
 
             bool verify_from_file(boost::filesystem::path proof_file_) {
+                ScopedStep step("verify_from_file");
                 create_lpc_scheme();
 
                 using ProofMarshalling = nil::crypto3::marshalling::types::
                     placeholder_proof<nil::marshalling::field_type<Endianness>, Proof>;
 
                 BOOST_LOG_TRIVIAL(info) << "Reading proof from file";
-                auto marshalled_proof = detail::decode_marshalling_from_file<ProofMarshalling>(proof_file_, true);
+                auto marshalled_proof = detail::decode_marshalling_from_file<ProofMarshalling>(
+                    proof_file_,
+                    output_options_.proof_format == ProofFormat::HEX
+                );
                 if (!marshalled_proof) {
                     return false;
                 }
@@ -247,6 +372,7 @@ namespace nil {
             }
 
             bool save_preprocessed_common_data_to_file(boost::filesystem::path preprocessed_common_data_file) {
+                ScopedStep step("save_preprocessed_common_data");
                 BOOST_LOG_TRIVIAL(info) << "Writing preprocessed common data to " << preprocessed_common_data_file << std::endl;
                 auto marshalled_common_data =
                     nil::crypto3::marshalling::types::fill_placeholder_common_data<Endianness, CommonData>(
@@ -263,6 +389,7 @@ namespace nil {
             }
 
             bool read_preprocessed_common_data_from_file(boost::filesystem::path preprocessed_common_data_file) {
+                ScopedStep step("read_preprocessed_common_data");
                 BOOST_LOG_TRIVIAL(info) << "Read preprocessed common data from " << preprocessed_common_data_file << std::endl;
 
                 using CommonDataMarshalling = nil::crypto3::marshalling::types::placeholder_common_data<TTypeBase, CommonData>;
@@ -282,6 +409,7 @@ namespace nil {
             // This includes not only the common data, but also merkle trees, polynomials, etc, everything that a
             // public preprocessor generates.
             bool save_public_preprocessed_data_to_file(boost::filesystem::path preprocessed_data_file) {
+                ScopedStep step("save_public_preprocessed_data");
                 using namespace nil::crypto3::marshalling::types;
 
                 BOOST_LOG_TRIVIAL(info) << "Writing all preprocessed public data to " <<
@@ -294,7 +422,9 @@ namespace nil {
                     );
                 bool res = nil::proof_generator::detail::encode_marshalling_to_file(
                     preprocessed_data_file,
-                    marshalled_preprocessed_public_data
+                    marshalled_preprocessed_public_data,
+                    false,
+                    output_options_.compression_level
                 );
                 if (res) {
                     BOOST_LOG_TRIVIAL(info) << "Preprocessed public data written.";
@@ -303,6 +433,7 @@ namespace nil {
             }
 
             bool read_public_preprocessed_data_from_file(boost::filesystem::path preprocessed_data_file) {
+                ScopedStep step("read_public_preprocessed_data");
                 BOOST_LOG_TRIVIAL(info) << "Read preprocessed data from " << preprocessed_data_file << std::endl;
 
                 using namespace nil::crypto3::marshalling::types;
@@ -323,6 +454,7 @@ namespace nil {
             }
 
             bool save_commitment_state_to_file(boost::filesystem::path commitment_scheme_state_file) {
+                ScopedStep step("save_commitment_state");
                 using namespace nil::crypto3::marshalling::types;
 
                 BOOST_LOG_TRIVIAL(info) << "Writing commitment_state to " <<
@@ -332,7 +464,9 @@ namespace nil {
                     *lpc_scheme_);
                 bool res = nil::proof_generator::detail::encode_marshalling_to_file(
                     commitment_scheme_state_file,
-                    marshalled_lpc_state
+                    marshalled_lpc_state,
+                    false,
+                    output_options_.compression_level
                 );
                 if (res) {
                     BOOST_LOG_TRIVIAL(info) << "Commitment scheme written.";
@@ -341,6 +475,7 @@ namespace nil {
             }
 
             bool read_commitment_scheme_from_file(boost::filesystem::path commitment_scheme_state_file) {
+                ScopedStep step("read_commitment_scheme");
                 BOOST_LOG_TRIVIAL(info) << "Read commitment scheme from " << commitment_scheme_state_file << std::endl;
 
                 using namespace nil::crypto3::marshalling::types;
@@ -357,6 +492,7 @@ namespace nil {
             }
 
             bool verify(const Proof& proof) const {
+                ScopedStep step("verify");
                 BOOST_LOG_TRIVIAL(info) << "Verifying proof...";
                 bool verification_result =
                     nil::crypto3::zk::snark::placeholder_verifier<BlueprintField, PlaceholderParams>::process(
@@ -368,6 +504,7 @@ namespace nil {
                     );
 
                 if (verification_result) {
+                    PROOF_GENERATOR_COUNT(PROOFS_VERIFIED, 1);
                     BOOST_LOG_TRIVIAL(info) << "Proof is verified";
                 } else {
                     BOOST_LOG_TRIVIAL(error) << "Proof verification failed";
@@ -377,6 +514,7 @@ namespace nil {
             }
 
             bool read_circuit(const boost::filesystem::path& circuit_file_) {
+                ScopedStep step("read_circuit");
                 BOOST_LOG_TRIVIAL(info) << "Read circuit from " << circuit_file_ << std::endl;
 
                 using ConstraintMarshalling =
@@ -394,26 +532,90 @@ namespace nil {
                 return true;
             }
 
-            bool read_assignment_table(const boost::filesystem::path& assignment_table_file_) {
+            // Sections left out are not read from disk when the file can be mapped, and are empty in the table.
+            // Both the marshalled and the indexed table formats are accepted.
+            bool read_assignment_table(
+                const boost::filesystem::path& assignment_table_file_,
+                const TableSections& sections = all_table_sections
+            ) {
+                ScopedStep step("read_assignment_table");
                 BOOST_LOG_TRIVIAL(info) << "Read assignment table from " << assignment_table_file_ << std::endl;
 
-                using TableValueMarshalling =
-                    nil::crypto3::marshalling::types::plonk_assignment_table<TTypeBase, AssignmentTable>;
-                auto marshalled_table =
-                    detail::decode_marshalling_from_file<TableValueMarshalling>(assignment_table_file_);
-                if (!marshalled_table) {
+                // Columns are decoded right into the table, so only the table itself and the (page cache backed)
+                // file mapping are alive during loading. Indexed tables are decoded a column per thread.
+                using TableReader = AssignmentTableReader<Endianness, BlueprintField, Column>;
+                using IndexedTableReader = IndexedTable<Endianness, BlueprintField, Column>;
+                std::size_t bytes_touched = 0;
+                auto decode = [&](const std::uint8_t* data, std::size_t size)
+                    -> std::optional<std::pair<TableDescription, AssignmentTable>> {
+                    if (indexed_table::is_indexed_table(data, size)) {
+                        auto indexed = IndexedTableReader::open(data, size);
+                        if (!indexed) {
+                            return std::nullopt;
+                        }
+                        bytes_touched = indexed->columns().empty() ? size : indexed->columns().front().offset;
+                        bytes_touched += indexed->sections_size(sections);
+                        return indexed->read(sections);
+                    }
+                    auto table = TableReader::read(data, size, sections);
+                    if (table) {
+                        bytes_touched = size - TableReader::skipped_size(table->first, sections);
+                    }
+                    return table;
+                };
+
+                auto input = InputFile::open(assignment_table_file_.string());
+                if (!input) {
                     return false;
                 }
-                auto [table_description, assignment_table] =
-                    nil::crypto3::marshalling::types::make_assignment_table<Endianness, AssignmentTable>(
-                        *marshalled_table
-                    );
-                table_description_.emplace(table_description);
-                assignment_table_.emplace(std::move(assignment_table));
+                std::optional<std::pair<TableDescription, AssignmentTable>> table;
+                auto mapped = input->map(false);
+                if (mapped.has_value()) {
+                    table = decode(mapped->data(), mapped->size());
+                    Metrics::instance().add_bytes_read(bytes_touched);
+                } else {
+                    // Standard input or a pipe: the marshalled format is decoded while the producer of the table
+                    // is still writing it, the indexed one needs the whole table first.
+                    detail::FdByteReader reader(input->fd(), input->path());
+                    const std::uint8_t* head;
+                    if (reader.peek(sizeof(indexed_table::magic), head) &&
+                        std::equal(head, head + sizeof(indexed_table::magic), indexed_table::magic)) {
+                        auto v = reader.read_to_end();
+                        if (v.has_value()) {
+                            table = decode(v->data(), v->size());
+                        }
+                    } else {
+                        table = TableReader::read(reader, sections);
+                    }
+                }
+                if (!table) {
+                    BOOST_LOG_TRIVIAL(error) << "Failed to decode assignment table from " << assignment_table_file_;
+                    return false;
+                }
+                table_description_.emplace(table->first);
+                assignment_table_.emplace(std::move(table->second));
                 return true;
             }
 
+            // Converts the loaded table to the indexed format, which can be decoded in parallel and in parts.
+            bool save_indexed_assignment_table(const boost::filesystem::path& indexed_table_file) {
+                ScopedStep step("save_indexed_assignment_table");
+                BOOST_LOG_TRIVIAL(info) << "Writing indexed assignment table to " << indexed_table_file << std::endl;
+
+                bool res = IndexedTable<Endianness, BlueprintField, Column>::write(
+                    *table_description_,
+                    *assignment_table_,
+                    indexed_table_file.string(),
+                    output_options_.async_write
+                );
+                if (res) {
+                    BOOST_LOG_TRIVIAL(info) << "Indexed assignment table written.";
+                }
+                return res;
+            }
+
             bool save_assignment_description(const boost::filesystem::path& assignment_description_file) {
+                ScopedStep step("save_assignment_description");
                 BOOST_LOG_TRIVIAL(info) << "Writing assignment description to " << assignment_description_file << std::endl;
 
                 auto marshalled_assignment_description =
@@ -431,6 +633,7 @@ namespace nil {
             }
 
             bool read_assignment_description(const boost::filesystem::path& assignment_description_file_) {
+                ScopedStep step("read_assignment_description");
                 BOOST_LOG_TRIVIAL(info) << "Read assignment description from " << assignment_description_file_ << std::endl;
 
                 using TableDescriptionMarshalling =
@@ -448,14 +651,132 @@ namespace nil {
                 return true;
             }
 
+            CircuitShape circuit_shape() const {
+                BOOST_ASSERT(table_description_);
+                BOOST_ASSERT(constraint_system_);
+                CircuitShape shape;
+                shape.rows_amount = table_description_->rows_amount;
+                shape.witness_columns = table_description_->witness_columns;
+                shape.public_input_columns = table_description_->public_input_columns;
+                shape.constant_columns = table_description_->constant_columns;
+                shape.selector_columns = table_description_->selector_columns;
+                shape.gates_amount = constraint_system_->gates().size();
+                for (const auto& gate : constraint_system_->gates()) {
+                    shape.constraints_amount += gate.constraints.size();
+                }
+                shape.max_gate_degree =
+                    std::max(constraint_system_->max_gates_degree(), constraint_system_->max_lookup_gates_degree());
+                shape.lookup_gates_amount = constraint_system_->lookup_gates().size();
+                shape.element_size = AssignmentTableReader<Endianness, BlueprintField, Column>::element_size();
+                return shape;
+            }
+
+            // Predicts the resources of the stages from the circuit and the table description, without touching
+            // the table. Written to the standard output when estimate_file is empty.
+            bool estimate_resources(
+                const boost::filesystem::path& cost_model_file,
+                const std::string& hash_type,
+                const boost::filesystem::path& estimate_file
+            ) const {
+                ScopedStep step("estimate_resources");
+                std::optional<CostModel> model = CostModel::load(cost_model_file, hash_type);
+                if (!model) {
+                    return false;
+                }
+                const std::string estimate = model->estimate_json(
+                    circuit_shape(),
+                    ProofParameters {lambda_, expand_factor_, max_quotient_chunks_, grind_}
+                );
+                if (estimate_file.empty()) {
+                    std::cout << estimate << std::flush;
+                    return true;
+                }
+                std::ofstream file(estimate_file.string(), std::ios_base::out | std::ios_base::trunc);
+                file << estimate;
+                if (!file) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to write resource estimate to " << estimate_file;
+                    return false;
+                }
+                BOOST_LOG_TRIVIAL(info) << "Resource estimate written to " << estimate_file;
+                return true;
+            }
+
+            // Replaces lambda, expand factor and quotient chunks by the ones the cost model finds best for the
+            // objective at security_bits, 0 meaning the security of the current parameters. Must run before the
+            // commitment scheme is created, and with the same arguments in every stage of a proof.
+            bool tune_parameters(
+                TuningObjective objective,
+                std::size_t security_bits,
+                const boost::filesystem::path& cost_model_file,
+                const std::string& hash_type
+            ) {
+                ScopedStep step("tune_parameters");
+                std::optional<CostModel> model = CostModel::load(cost_model_file, hash_type);
+                if (!model) {
+                    return false;
+                }
+                if (security_bits == 0) {
+                    security_bits =
+                        conjectured_security_bits(ProofParameters {lambda_, expand_factor_, max_quotient_chunks_, grind_});
+                }
+                const ProofParameters tuned = model->tune(circuit_shape(), objective, security_bits, grind_);
+                // A commitment scheme read from its state file is fixed, the tuning must arrive at its parameters.
+                if (lpc_scheme_.has_value()) {
+                    const FriParams& fri_params = lpc_scheme_->get_fri_params();
+                    if (fri_params.lambda != tuned.lambda || fri_params.expand_factor != tuned.expand_factor) {
+                        BOOST_LOG_TRIVIAL(error)
+                            << "Tuned lambda " << tuned.lambda << " and expand factor " << tuned.expand_factor
+                            << " differ from lambda " << fri_params.lambda << " and expand factor "
+                            << fri_params.expand_factor << " of the commitment state file. Run the stages with the "
+                            << "same --auto-params, --security-bits and --cost-model, or pass the parameters "
+                            << "explicitly";
+                        return false;
+                    }
+                }
+                lambda_ = tuned.lambda;
+                expand_factor_ = tuned.expand_factor;
+                max_quotient_chunks_ = tuned.max_quotient_chunks;
+                BOOST_LOG_TRIVIAL(info) << "Chose lambda " << lambda_ << ", expand factor " << expand_factor_
+                                        << ", max quotient chunks " << max_quotient_chunks_ << " for "
+                                        << security_bits << " bits of conjectured security";
+
+                Metrics& metrics = Metrics::instance();
+                metrics.set_info("lambda", std::to_string(lambda_));
+                metrics.set_info("expand_factor", std::to_string(expand_factor_));
+                metrics.set_info("max_quotient_chunks", std::to_string(max_quotient_chunks_));
+                metrics.set_info("security_bits", std::to_string(security_bits));
+                return true;
+            }
+
+            // Grinding adds grind_ bits of proof of work before the FRI queries, 0 disables it.
             void create_lpc_scheme() {
-                // Lambdas and grinding bits should be passed through preprocessor directives
                 std::size_t table_rows_log = std::ceil(std::log2(table_description_->rows_amount));
 
-                lpc_scheme_.emplace(FriParams(1, table_rows_log, lambda_, expand_factor_));
+                lpc_scheme_.emplace(cached_fri_params(table_rows_log));
+            }
+
+            // FRI parameters, with the evaluation domain set in them, depend only on the table size and the
+            // commitment parameters. Copies share the domains, together with the tables they compute on first use,
+            // so every prover of the process creating parameters of the same size gets them without domain setup.
+            FriParams cached_fri_params(std::size_t table_rows_log) const {
+                static std::mutex cache_mutex;
+                static std::map<std::array<std::size_t, 4>, FriParams> cache;
+
+                const std::array<std::size_t, 4> key = {table_rows_log, lambda_, expand_factor_, grind_};
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                auto it = cache.find(key);
+                if (it == cache.end()) {
+                    ScopedStep step("domain_setup");
+                    it = cache.emplace(key, FriParams(1, table_rows_log, lambda_, expand_factor_, grind_ != 0, grind_))
+                             .first;
+                } else {
+                    BOOST_LOG_TRIVIAL(debug) << "Reusing evaluation domains for 2^" << table_rows_log << " rows";
+                }
+                return it->second;
             }
 
             bool preprocess_public_data() {
+                ScopedStep step("preprocess_public_data");
                 public_inputs_.emplace(assignment_table_->public_inputs());
 
                 create_lpc_scheme();
@@ -474,7 +795,44 @@ namespace nil {
                 return true;
             }
 
+            // Same as preprocess_public_data, but takes the result from the cache when the circuit, the public part
+            // of the table and the commitment parameters were already preprocessed, and fills the cache otherwise.
+            bool preprocess_public_data_cached(const PreprocessCache& cache) {
+                const std::string key = preprocess_cache_key();
+                if (auto entry = cache.lookup(key)) {
+                    BOOST_LOG_TRIVIAL(info) << "Taking preprocessed public data from cache " << *entry;
+                    public_inputs_.emplace(assignment_table_->public_inputs());
+                    if (read_public_preprocessed_data_from_file(*entry / PreprocessCache::preprocessed_data_file) &&
+                        read_commitment_scheme_from_file(*entry / PreprocessCache::commitment_scheme_state_file)) {
+                        return true;
+                    }
+                    BOOST_LOG_TRIVIAL(warning) << "Cache entry " << *entry << " is unusable, preprocessing again";
+                    public_inputs_.reset();
+                    public_preprocessed_data_.reset();
+                }
+
+                if (!preprocess_public_data()) {
+                    return false;
+                }
+                // Failing to fill the cache is not an error, the next run will just preprocess again.
+                if (auto staging = cache.begin_insert(key)) {
+                    if (save_public_preprocessed_data_to_file(*staging / PreprocessCache::preprocessed_data_file) &&
+                        save_commitment_state_to_file(*staging / PreprocessCache::commitment_scheme_state_file)) {
+                        cache.commit_insert(*staging, key);
+                    } else {
+                        cache.abandon_insert(*staging);
+                    }
+                }
+                return true;
+            }
+
             bool preprocess_private_data() {
+                ScopedStep step("preprocess_private_data");
+                // Public inputs are taken in preprocess_public_data when it runs, otherwise (prove stage) take
+                // them here, before the table is consumed.
+                if (!public_inputs_) {
+                    public_inputs_.emplace(assignment_table_->public_inputs());
+                }
 
                 BOOST_LOG_TRIVIAL(info) << "Preprocessing private data";
                 private_preprocessed_data_.emplace(
@@ -488,54 +846,314 @@ namespace nil {
                 return true;
             }
 
+            // Keeps a copy of the commitment scheme and of the table description the public data was
+            // preprocessed for, so that more assignment tables can be proven against them afterwards.
+            bool snapshot_preprocessed_state() {
+                BOOST_ASSERT(public_preprocessed_data_);
+                BOOST_ASSERT(table_description_);
+                BOOST_ASSERT(lpc_scheme_);
+
+                preprocessed_table_description_.emplace(*table_description_);
+                lpc_scheme_snapshot_.emplace(*lpc_scheme_);
+                return true;
+            }
+
+            // Proves one more assignment table of the same circuit, reusing the circuit and the public
+            // preprocessed data held by this prover. snapshot_preprocessed_state() must be called first.
+            bool prove_assignment_table_to_file(
+                const boost::filesystem::path& assignment_table_file,
+                const boost::filesystem::path& proof_file,
+                const boost::filesystem::path& json_file,
+                bool skip_verification
+            ) {
+                if (!lpc_scheme_snapshot_ || !preprocessed_table_description_) {
+                    BOOST_LOG_TRIVIAL(error) << "No preprocessed state to prove " << assignment_table_file << " against";
+                    return false;
+                }
+                if (!read_assignment_table(assignment_table_file, proving_table_sections)) {
+                    return false;
+                }
+                if (!is_same_table_layout(*table_description_, *preprocessed_table_description_)) {
+                    BOOST_LOG_TRIVIAL(error) << "Assignment table " << assignment_table_file
+                                             << " does not match the layout of the preprocessed circuit";
+                    assignment_table_.reset();
+                    return false;
+                }
+
+                // Public inputs are not committed by the public preprocessor, but the preprocessed data carries
+                // them into the prover, so they have to be replaced with the ones of the current table.
+                public_inputs_.emplace(assignment_table_->public_inputs());
+                replace_preprocessed_public_inputs(*public_inputs_);
+
+                // Placeholder prover appends the batches of the current proof to the commitment scheme, start every
+                // proof from the preprocessed one.
+                lpc_scheme_.emplace(*lpc_scheme_snapshot_);
+
+                return preprocess_private_data() && generate_to_file(proof_file, json_file, skip_verification);
+            }
+
+            // Absorbs challenges into the transcript in order: first the ones from separate files, then the ones
+            // from the packed file, which is a concatenation of marshalled challenges.
             bool generate_aggregated_challenge_to_file(
                 const std::vector<boost::filesystem::path> &aggregate_input_files,
-                const boost::filesystem::path &aggregated_challenge_file
+                const boost::filesystem::path &packed_input_file,
+                const boost::filesystem::path &aggregated_challenge_file,
+                std::size_t max_concurrent_reads
             ) {
-                if (aggregate_input_files.empty()) {
+                ScopedStep step("generate_aggregated_challenge");
+                if (aggregate_input_files.empty() && packed_input_file.empty()) {
                     BOOST_LOG_TRIVIAL(error) << "No input files for challenge aggregation";
                     return false;
                 }
                 BOOST_LOG_TRIVIAL(info) << "Generating aggregated challenge to " << aggregated_challenge_file;
-                // check that we can access all input files
-                for (const auto &input_file : aggregate_input_files) {
-                    BOOST_LOG_TRIVIAL(info) << "Reading challenge from " << input_file;
-                    if (!nil::proof_generator::can_read_from_file(input_file.string())) {
-                        BOOST_LOG_TRIVIAL(error) << "Can't read file " << input_file;
-                        return false;
-                    }
+
+                auto challenges = read_challenges(aggregate_input_files, max_concurrent_reads);
+                if (!challenges) {
+                    return false;
                 }
+                if (!packed_input_file.empty() && !read_packed_challenges(packed_input_file, *challenges)) {
+                    return false;
+                }
+
                 // create the transcript
                 using transcript_hash_type = typename PlaceholderParams::transcript_hash_type;
                 using transcript_type = crypto3::zk::transcript::fiat_shamir_heuristic_sequential<transcript_hash_type>;
-                using challenge_marshalling_type =
-                    nil::crypto3::marshalling::types::field_element<
-                        TTypeBase, typename BlueprintField::value_type>;
                 transcript_type transcript;
-                // read challenges from input files and add them to the transcript
-                for (const auto &input_file : aggregate_input_files) {
-                    auto challenge = detail::decode_marshalling_from_file<challenge_marshalling_type>(input_file);
-                    if (!challenge) {
-                        BOOST_LOG_TRIVIAL(error) << "Failed to read challenge from " << input_file;
-                        return false;
-                    }
-                    transcript(challenge->value());
+                for (const auto &challenge : *challenges) {
+                    transcript(challenge);
                 }
+                PROOF_GENERATOR_COUNT(CHALLENGES_ABSORBED, challenges->size());
                 // produce the aggregated challenge
                 auto output_challenge = transcript.template challenge<BlueprintField>();
                 // marshall the challenge
-                challenge_marshalling_type marshalled_challenge(output_challenge);
+                ChallengeMarshalling marshalled_challenge(output_challenge);
                 // write the challenge to the output file
                 BOOST_LOG_TRIVIAL(info) << "Writing aggregated challenge to " << aggregated_challenge_file;
-                return detail::encode_marshalling_to_file<challenge_marshalling_type>
+                return detail::encode_marshalling_to_file<ChallengeMarshalling>
                     (aggregated_challenge_file, marshalled_challenge);
             }
 
         private:
-            const std::size_t expand_factor_;
-            const std::size_t max_quotient_chunks_;
-            const std::size_t lambda_;
+            using ChallengeMarshalling =
+                nil::crypto3::marshalling::types::field_element<TTypeBase, typename BlueprintField::value_type>;
+
+            // Challenge files are tiny, so reads are issued concurrently to hide the per-file latency.
+            std::optional<std::vector<typename BlueprintField::value_type>> read_challenges(
+                const std::vector<boost::filesystem::path>& input_files,
+                std::size_t max_concurrent_reads
+            ) const {
+                std::vector<typename BlueprintField::value_type> challenges(input_files.size());
+                std::vector<char> read_ok(input_files.size(), false);
+                run_in_parallel(input_files.size(), max_concurrent_reads, [&](std::size_t i) {
+                    BOOST_LOG_TRIVIAL(debug) << "Reading challenge from " << input_files[i];
+                    std::array<std::uint8_t, 128> buffer;
+                    auto size = read_small_file(input_files[i].string(), buffer.data(), buffer.size());
+                    if (!size) {
+                        return;
+                    }
+                    auto challenge =
+                        detail::decode_marshalling<ChallengeMarshalling>(buffer.data(), *size, input_files[i]);
+                    if (!challenge) {
+                        return;
+                    }
+                    challenges[i] = challenge->value();
+                    read_ok[i] = true;
+                });
+                for (std::size_t i = 0; i < input_files.size(); ++i) {
+                    if (!read_ok[i]) {
+                        BOOST_LOG_TRIVIAL(error) << "Failed to read challenge from " << input_files[i];
+                        return std::nullopt;
+                    }
+                }
+                return challenges;
+            }
+
+            bool read_packed_challenges(
+                const boost::filesystem::path& packed_input_file,
+                std::vector<typename BlueprintField::value_type>& challenges
+            ) const {
+                BOOST_LOG_TRIVIAL(info) << "Reading challenges from " << packed_input_file;
+                auto input = InputFile::open(packed_input_file.string());
+                if (!input) {
+                    return false;
+                }
+                std::optional<std::vector<std::uint8_t>> buffered;
+                auto mapped = input->map();
+                if (!mapped) {
+                    buffered = input->read_to_vector();
+                    if (!buffered) {
+                        return false;
+                    }
+                }
+                detail::ByteRangeReader reader(
+                    mapped ? mapped->data() : buffered->data(),
+                    mapped ? mapped->size() : buffered->size()
+                );
+                std::size_t challenges_amount = 0;
+                while (reader.remaining() > 0) {
+                    ChallengeMarshalling challenge;
+                    if (!reader.read(challenge)) {
+                        BOOST_LOG_TRIVIAL(error) << "Packed challenges file " << packed_input_file
+                                                 << " is truncated after " << challenges_amount << " challenges";
+                        return false;
+                    }
+                    challenges.push_back(challenge.value());
+                    ++challenges_amount;
+                }
+                BOOST_LOG_TRIVIAL(info) << "Read " << challenges_amount << " challenges";
+                return true;
+            }
+
+            std::optional<std::vector<std::uint8_t>> marshal_proof(const Proof& proof, const FriParams& fri_params) const {
+                ScopedStep marshalling_step("proof_marshalling");
+                auto filled_placeholder_proof =
+                    nil::crypto3::marshalling::types::fill_placeholder_proof<Endianness, Proof>(proof, fri_params);
+                return nil::proof_generator::detail::encode_marshalling(filled_placeholder_proof);
+            }
+
+            bool write_proof_to_file(
+                const std::vector<std::uint8_t>& proof_bytes,
+                const boost::filesystem::path& proof_file
+            ) const {
+                ScopedStep write_step("write_proof");
+                return output_options_.proof_format == ProofFormat::HEX
+                           ? write_vector_to_hex_file(proof_bytes, proof_file.string(), output_options_.async_write)
+                           : write_vector_to_file(proof_bytes, proof_file.string(), output_options_.async_write);
+            }
+
+            bool write_json_proof_to_file(const Proof& proof, const boost::filesystem::path& json_file) const {
+                auto json_sink = FileSink::open(json_file.string(), output_options_.async_write);
+                if (!json_sink) {
+                    return false;
+                }
+
+                ScopedStep json_step("json_generation");
+                std::string json_proof = nil::blueprint::recursive_verifier_generator<
+                                      PlaceholderParams,
+                                      nil::crypto3::zk::snark::placeholder_proof<BlueprintField, PlaceholderParams>,
+                                      typename nil::crypto3::zk::snark::placeholder_public_preprocessor<
+                                          BlueprintField,
+                                          PlaceholderParams>::preprocessed_data_type::common_data_type>(
+                                      *table_description_
+                )
+                                      .generate_input(*public_inputs_, proof, constraint_system_->public_input_sizes());
+                json_step.finish();
+
+                // The transpiler builds the whole document as one string, it is written out in place.
+                ScopedStep json_write_step("write_json");
+                json_sink->write(json_proof);
+                return json_sink->close();
+            }
+
+            // Digest of everything public preprocessor output depends on: the circuit, the public part of the
+            // table and the commitment parameters.
+            std::string preprocess_cache_key() const {
+                using KeyHash = nil::crypto3::hashes::sha2<256>;
+                using ElementMarshalling =
+                    nil::crypto3::marshalling::types::field_element<TTypeBase, typename BlueprintField::value_type>;
+
+                nil::crypto3::accumulator_set<KeyHash> accumulator;
+                std::vector<std::uint8_t> buffer;
+                auto flush = [&accumulator, &buffer]() {
+                    nil::crypto3::hash<KeyHash>(buffer.begin(), buffer.end(), accumulator);
+                    buffer.clear();
+                };
+                auto absorb_size = [&buffer](std::size_t value) {
+                    for (std::size_t i = 0; i < sizeof(value); ++i) {
+                        buffer.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+                    }
+                };
+                auto absorb_columns = [&](const auto& columns) {
+                    constexpr std::size_t flush_threshold = 1 << 16;
+                    absorb_size(columns.size());
+                    for (const auto& column : columns) {
+                        absorb_size(column.size());
+                        for (const auto& value : column) {
+                            ElementMarshalling marshalled_value(value);
+                            std::size_t offset = buffer.size();
+                            buffer.resize(offset + marshalled_value.length());
+                            auto write_iter = buffer.begin() + offset;
+                            marshalled_value.write(write_iter, marshalled_value.length());
+                            if (buffer.size() >= flush_threshold) {
+                                flush();
+                            }
+                        }
+                    }
+                };
+
+                const std::string parameters = std::string(typeid(CurveType).name()) + "/" +
+                                               typeid(HashType).name();
+                buffer.assign(parameters.begin(), parameters.end());
+                for (std::size_t value : {lambda_, expand_factor_, max_quotient_chunks_, grind_}) {
+                    absorb_size(value);
+                }
+                for (std::size_t value : {table_description_->witness_columns,
+                                          table_description_->public_input_columns,
+                                          table_description_->constant_columns,
+                                          table_description_->selector_columns,
+                                          table_description_->usable_rows_amount,
+                                          table_description_->rows_amount}) {
+                    absorb_size(value);
+                }
+
+                auto marshalled_circuit = detail::encode_marshalling(
+                    nil::crypto3::marshalling::types::fill_plonk_constraint_system<Endianness, ConstraintSystem>(
+                        *constraint_system_
+                    )
+                );
+                if (!marshalled_circuit) {
+                    throw std::runtime_error("Failed to encode circuit for preprocess cache key");
+                }
+                buffer.insert(buffer.end(), marshalled_circuit->begin(), marshalled_circuit->end());
+                flush();
+
+                absorb_columns(assignment_table_->public_inputs());
+                absorb_columns(assignment_table_->constants());
+                absorb_columns(assignment_table_->selectors());
+                flush();
+
+                typename KeyHash::digest_type digest = nil::crypto3::accumulators::extract::hash<KeyHash>(accumulator);
+                std::string key(2 * digest.size(), '0');
+                hex::encode(digest.data(), digest.size(), key.data());
+                return key;
+            }
+
+            static bool is_same_table_layout(const TableDescription& lhs, const TableDescription& rhs) {
+                return lhs.witness_columns == rhs.witness_columns &&
+                       lhs.public_input_columns == rhs.public_input_columns &&
+                       lhs.constant_columns == rhs.constant_columns &&
+                       lhs.selector_columns == rhs.selector_columns &&
+                       lhs.usable_rows_amount == rhs.usable_rows_amount && lhs.rows_amount == rhs.rows_amount;
+            }
+
+            void replace_preprocessed_public_inputs(
+                const typename AssignmentTable::public_input_container_type& public_inputs
+            ) {
+                using PublicPolynomialTable = std::decay_t<decltype(public_preprocessed_data_->public_polynomial_table)>;
+
+                const std::size_t rows_amount = table_description_->rows_amount;
+                typename PublicPolynomialTable::public_input_container_type public_input_polynomials;
+                public_input_polynomials.reserve(public_inputs.size());
+                for (const auto& column : public_inputs) {
+                    std::vector<typename BlueprintField::value_type> values(column.begin(), column.end());
+                    values.resize(rows_amount, BlueprintField::value_type::zero());
+                    public_input_polynomials.emplace_back(rows_amount - 1, values);
+                }
+
+                const auto& current = public_preprocessed_data_->public_polynomial_table;
+                public_preprocessed_data_->public_polynomial_table = PublicPolynomialTable(
+                    std::move(public_input_polynomials),
+                    current.constants(),
+                    current.selectors()
+                );
+            }
+
+            // Set by tune_parameters with --auto-params.
+            std::size_t expand_factor_;
+            std::size_t max_quotient_chunks_;
+            std::size_t lambda_;
             const std::size_t grind_;
+            const OutputOptions output_options_;
 
             std::optional<PublicPreprocessedData> public_preprocessed_data_;
 
@@ -549,6 +1167,10 @@ namespace nil {
             std::optional<ConstraintSystem> constraint_system_;
             std::optional<AssignmentTable> assignment_table_;
             std::optional<LpcScheme> lpc_scheme_;
+
+            // Used when several assignment tables are proven against the same preprocessed data.
+            std::optional<TableDescription> preprocessed_table_description_;
+            std::optional<LpcScheme> lpc_scheme_snapshot_;
         };
 
     } // namespace proof_generator
@@ -0,0 +1,227 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_PROVER_SERVER_HPP
+#define PROOF_GENERATOR_PROVER_SERVER_HPP
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <nil/proof-generator/prove_jobs.hpp>
+
+namespace nil {
+    namespace proof_generator {
+        namespace detail {
+            // Upper bound for a single request line, three paths and separators.
+            constexpr std::size_t max_prove_request_length = 3 * PATH_MAX + 8;
+
+            // Closes the descriptor when leaving the scope.
+            class ScopedFd {
+            public:
+                explicit ScopedFd(int fd)
+                    : fd_(fd) {
+                }
+                ScopedFd(const ScopedFd&) = delete;
+                ScopedFd& operator=(const ScopedFd&) = delete;
+                ~ScopedFd() {
+                    if (fd_ >= 0) {
+                        ::close(fd_);
+                    }
+                }
+
+                int get() const {
+                    return fd_;
+                }
+
+            private:
+                int fd_;
+            };
+
+            inline std::optional<std::string> receive_line(int fd) {
+                std::string line;
+                char c;
+                while (line.size() < max_prove_request_length) {
+                    ssize_t received = ::recv(fd, &c, 1, 0);
+                    if (received < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (received <= 0) {
+                        if (line.empty()) {
+                            return std::nullopt;
+                        }
+                        return line;
+                    }
+                    if (c == '\n') {
+                        return line;
+                    }
+                    line.push_back(c);
+                }
+                return std::nullopt;
+            }
+
+            inline void send_reply(int fd, const std::string& reply) {
+                std::size_t sent = 0;
+                while (sent < reply.size()) {
+                    ssize_t res = ::send(fd, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+                    if (res < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (res <= 0) {
+                        BOOST_LOG_TRIVIAL(warning) << "Client disconnected before the reply was sent";
+                        return;
+                    }
+                    sent += res;
+                }
+            }
+
+            // Removes a socket left by a server which has not shut down properly. Anything else at the path, or a
+            // socket some server still accepts connections on, is kept and reported.
+            inline bool remove_stale_socket(const boost::filesystem::path& socket_path, const sockaddr_un& address) {
+                boost::system::error_code ec;
+                auto status = boost::filesystem::symlink_status(socket_path, ec);
+                if (status.type() == boost::filesystem::file_not_found) {
+                    return true;
+                }
+                if (status.type() != boost::filesystem::socket_file) {
+                    BOOST_LOG_TRIVIAL(error) << socket_path << " exists and is not a socket";
+                    return false;
+                }
+
+                ScopedFd probe(::socket(AF_UNIX, SOCK_STREAM, 0));
+                if (probe.get() < 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to create socket: " << std::strerror(errno);
+                    return false;
+                }
+                if (::connect(probe.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Another server is already listening on " << socket_path;
+                    return false;
+                }
+                if (errno != ECONNREFUSED) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to check socket " << socket_path << ": "
+                                             << std::strerror(errno);
+                    return false;
+                }
+
+                if (!boost::filesystem::remove(socket_path, ec) && ec) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to remove stale socket " << socket_path << ": "
+                                             << ec.message();
+                    return false;
+                }
+                return true;
+            }
+        } // namespace detail
+
+        // Serves prove jobs over a local Unix socket until "shutdown" request is received.
+        // Every connection carries one request line, either a job "<assignment-table> <proof> [<json-proof>]"
+        // or "shutdown". The server answers "ok\n" or "error\n" once the job is done.
+        // Jobs are proven one by one against the preprocessed state already loaded into the prover.
+        template<typename ProverType>
+        bool serve_prove_jobs(ProverType& prover, const boost::filesystem::path& socket_path, bool skip_verification) {
+            sockaddr_un address {};
+            address.sun_family = AF_UNIX;
+            if (socket_path.string().size() >= sizeof(address.sun_path)) {
+                BOOST_LOG_TRIVIAL(error) << socket_path << ": socket path is too long. Maximum allowed length is "
+                                         << sizeof(address.sun_path) - 1 << " characters.";
+                return false;
+            }
+            std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+            detail::ScopedFd server(::socket(AF_UNIX, SOCK_STREAM, 0));
+            if (server.get() < 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to create socket: " << std::strerror(errno);
+                return false;
+            }
+
+            if (!detail::remove_stale_socket(socket_path, address)) {
+                return false;
+            }
+
+            boost::system::error_code ec;
+            if (::bind(server.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to bind socket " << socket_path << ": " << std::strerror(errno);
+                return false;
+            }
+            if (::listen(server.get(), SOMAXCONN) != 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to listen on socket " << socket_path << ": "
+                                         << std::strerror(errno);
+                boost::filesystem::remove(socket_path, ec);
+                return false;
+            }
+
+            BOOST_LOG_TRIVIAL(info) << "Waiting for prove jobs on " << socket_path;
+            std::size_t jobs_done = 0, jobs_failed = 0;
+            bool serving = true;
+            while (serving) {
+                detail::ScopedFd client(::accept(server.get(), nullptr, nullptr));
+                if (client.get() < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) {
+                        continue;
+                    }
+                    BOOST_LOG_TRIVIAL(error) << "Unable to accept connection: " << std::strerror(errno);
+                    break;
+                }
+
+                auto request = detail::receive_line(client.get());
+                if (!request) {
+                    BOOST_LOG_TRIVIAL(warning) << "Empty or too long request, ignoring";
+                    detail::send_reply(client.get(), "error\n");
+                    continue;
+                }
+                if (*request == "shutdown") {
+                    BOOST_LOG_TRIVIAL(info) << "Shutdown requested";
+                    detail::send_reply(client.get(), "ok\n");
+                    serving = false;
+                    continue;
+                }
+
+                auto job = parse_prove_job(*request);
+                bool job_result = false;
+                if (job) {
+                    BOOST_LOG_TRIVIAL(info) << "Proving " << job->assignment_table_file_path;
+                    try {
+                        job_result = prover.prove_assignment_table_to_file(
+                            job->assignment_table_file_path,
+                            job->proof_file_path,
+                            job->json_file_path,
+                            skip_verification
+                        );
+                    } catch (const std::exception& e) {
+                        BOOST_LOG_TRIVIAL(error) << e.what();
+                    }
+                }
+                job_result ? ++jobs_done : ++jobs_failed;
+                detail::send_reply(client.get(), job_result ? "ok\n" : "error\n");
+            }
+
+            boost::filesystem::remove(socket_path, ec);
+            BOOST_LOG_TRIVIAL(info) << "Server stopped, " << jobs_done << " jobs done, " << jobs_failed << " failed";
+            return !serving;
+        }
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_PROVER_SERVER_HPP
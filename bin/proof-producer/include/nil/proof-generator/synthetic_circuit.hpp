@@ -0,0 +1,197 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_SYNTHETIC_CIRCUIT_HPP
+#define PROOF_GENERATOR_SYNTHETIC_CIRCUIT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nil/crypto3/zk/snark/arithmetization/plonk/assignment.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/constraint.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/constraint_system.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/gate.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/table_description.hpp>
+#include <nil/crypto3/zk/snark/arithmetization/plonk/variable.hpp>
+
+namespace nil {
+    namespace proof_generator {
+
+        struct SyntheticCircuitOptions {
+            static constexpr std::size_t min_rows_log = 10;
+            static constexpr std::size_t max_rows_log = 22;
+
+            std::size_t rows_log = min_rows_log;
+            std::size_t witness_columns = 15;
+            std::size_t public_input_columns = 1;
+            std::size_t constant_columns = 1;
+            // Every selector column switches one gate.
+            std::size_t selector_columns = 1;
+            std::size_t gate_degree = 2;
+            std::uint64_t seed = 0;
+        };
+
+        // Circuit and satisfying assignment table of a given shape, for benchmarking the prover without
+        // external assigner output.
+        // Witness columns are split into groups of gate_degree inputs followed by one output. Gate i checks
+        //     output = (i + 1) * input_0 * ... * input_{degree - 1} + constant_0
+        // for every group, and is switched on at the usable rows r with r % selector_columns == i, so exactly one
+        // gate holds on each usable row. Columns that do not fit into a group, public inputs and the rest of
+        // the constants are filled with random values.
+        template<typename FieldType>
+        class SyntheticCircuit {
+        public:
+            using FieldValue = typename FieldType::value_type;
+            using Variable = nil::crypto3::zk::snark::plonk_variable<FieldValue>;
+            using Constraint = nil::crypto3::zk::snark::plonk_constraint<FieldType>;
+            using Gate = nil::crypto3::zk::snark::plonk_gate<FieldType, Constraint>;
+            using ConstraintSystem = nil::crypto3::zk::snark::plonk_constraint_system<FieldType>;
+            using TableDescription = nil::crypto3::zk::snark::plonk_table_description<FieldType>;
+            using Column = nil::crypto3::zk::snark::plonk_column<FieldType>;
+            using AssignmentTable = nil::crypto3::zk::snark::plonk_table<FieldType, Column>;
+
+            // Returns description of the problem if options can't make a valid circuit.
+            static std::optional<std::string> check_options(const SyntheticCircuitOptions& options) {
+                if (options.rows_log < SyntheticCircuitOptions::min_rows_log ||
+                    options.rows_log > SyntheticCircuitOptions::max_rows_log) {
+                    return "rows log must be in [" + std::to_string(SyntheticCircuitOptions::min_rows_log) + ", " +
+                           std::to_string(SyntheticCircuitOptions::max_rows_log) + "]";
+                }
+                if (options.gate_degree == 0) {
+                    return "gate degree must be positive";
+                }
+                if (options.witness_columns < options.gate_degree + 1) {
+                    return "gate of degree " + std::to_string(options.gate_degree) + " needs at least " +
+                           std::to_string(options.gate_degree + 1) + " witness columns";
+                }
+                if (options.selector_columns == 0) {
+                    return "at least one selector column is needed";
+                }
+                return std::nullopt;
+            }
+
+            static ConstraintSystem make_constraint_system(const SyntheticCircuitOptions& options) {
+                std::vector<Gate> gates;
+                for (std::size_t gate = 0; gate < options.selector_columns; ++gate) {
+                    std::vector<Constraint> constraints;
+                    for (std::size_t group = 0; group < groups_amount(options); ++group) {
+                        std::size_t first_column = group * (options.gate_degree + 1);
+                        Constraint product = witness(first_column);
+                        for (std::size_t input = 1; input < options.gate_degree; ++input) {
+                            product = product * witness(first_column + input);
+                        }
+                        Constraint constraint =
+                            witness(first_column + options.gate_degree) - product * Constraint(gate_factor(gate));
+                        if (options.constant_columns > 0) {
+                            constraint = constraint - Constraint(Variable(0, 0, true, Variable::column_type::constant));
+                        }
+                        constraints.push_back(constraint);
+                    }
+                    gates.emplace_back(gate, constraints);
+                }
+                return ConstraintSystem(gates, {});
+            }
+
+            static std::pair<TableDescription, AssignmentTable> make_assignment_table(
+                const SyntheticCircuitOptions& options
+            ) {
+                const std::size_t rows_amount = std::size_t(1) << options.rows_log;
+                // The last row is left out of the gates.
+                const std::size_t usable_rows_amount = rows_amount - 1;
+                std::mt19937_64 generator(options.seed);
+                auto random_column = [&generator, rows_amount]() {
+                    Column column(rows_amount);
+                    for (auto& cell : column) {
+                        cell = FieldValue(generator());
+                    }
+                    return column;
+                };
+
+                std::vector<Column> public_inputs(options.public_input_columns), constants(options.constant_columns);
+                for (auto& column : public_inputs) {
+                    column = random_column();
+                }
+                for (auto& column : constants) {
+                    column = random_column();
+                }
+
+                std::vector<Column> selectors(options.selector_columns, Column(rows_amount, FieldValue::zero()));
+                for (std::size_t row = 0; row < usable_rows_amount; ++row) {
+                    selectors[row % options.selector_columns][row] = FieldValue::one();
+                }
+
+                std::vector<Column> witnesses(options.witness_columns);
+                for (auto& column : witnesses) {
+                    column = random_column();
+                }
+                for (std::size_t row = 0; row < usable_rows_amount; ++row) {
+                    FieldValue factor = gate_factor(row % options.selector_columns);
+                    for (std::size_t group = 0; group < groups_amount(options); ++group) {
+                        std::size_t first_column = group * (options.gate_degree + 1);
+                        FieldValue output = factor;
+                        for (std::size_t input = 0; input < options.gate_degree; ++input) {
+                            output *= witnesses[first_column + input][row];
+                        }
+                        if (options.constant_columns > 0) {
+                            output += constants[0][row];
+                        }
+                        witnesses[first_column + options.gate_degree][row] = output;
+                    }
+                }
+
+                TableDescription description(
+                    options.witness_columns,
+                    options.public_input_columns,
+                    options.constant_columns,
+                    options.selector_columns,
+                    usable_rows_amount,
+                    rows_amount
+                );
+                return std::make_pair(
+                    description,
+                    AssignmentTable(
+                        typename AssignmentTable::private_table_type(std::move(witnesses)),
+                        typename AssignmentTable::public_table_type(
+                            std::move(public_inputs),
+                            std::move(constants),
+                            std::move(selectors)
+                        )
+                    )
+                );
+            }
+
+        private:
+            static std::size_t groups_amount(const SyntheticCircuitOptions& options) {
+                return options.witness_columns / (options.gate_degree + 1);
+            }
+
+            static FieldValue gate_factor(std::size_t gate) {
+                return FieldValue(gate + 1);
+            }
+
+            static Constraint witness(std::size_t index) {
+                return Constraint(Variable(index, 0, true, Variable::column_type::witness));
+            }
+        };
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_SYNTHETIC_CIRCUIT_HPP
@@ -0,0 +1,241 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+#ifndef PROOF_GENERATOR_THREAD_PLACEMENT_HPP
+#define PROOF_GENERATOR_THREAD_PLACEMENT_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+namespace nil {
+    namespace proof_generator {
+        namespace detail {
+            // From <numaif.h>, spelled out to avoid depending on libnuma.
+            constexpr int mpol_bind = 2;
+            constexpr int mpol_interleave = 3;
+            constexpr std::size_t max_numa_nodes = 1024;
+
+            // Parses the kernel cpu list format, e.g. "0-3,8,10-11".
+            inline std::optional<std::vector<int>> parse_cpu_list(const std::string& list) {
+                std::vector<int> cpus;
+                std::size_t position = 0;
+                while (position < list.size()) {
+                    std::size_t end = list.find(',', position);
+                    if (end == std::string::npos) {
+                        end = list.size();
+                    }
+                    std::string item = list.substr(position, end - position);
+                    position = end + 1;
+
+                    std::size_t dash = item.find('-');
+                    std::string first_str = item.substr(0, dash);
+                    std::string last_str = dash == std::string::npos ? first_str : item.substr(dash + 1);
+                    auto is_number = [](const std::string& str) {
+                        return !str.empty() && str.size() < 7 &&
+                               std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+                    };
+                    if (!is_number(first_str) || !is_number(last_str)) {
+                        return std::nullopt;
+                    }
+                    int first = std::stoi(first_str), last = std::stoi(last_str);
+                    if (first > last) {
+                        return std::nullopt;
+                    }
+                    for (int cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                }
+                std::sort(cpus.begin(), cpus.end());
+                cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+                return cpus;
+            }
+
+            inline std::string format_cpu_list(const std::vector<int>& cpus) {
+                std::string result;
+                for (std::size_t i = 0; i < cpus.size();) {
+                    std::size_t j = i;
+                    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+                        ++j;
+                    }
+                    result += (result.empty() ? "" : ",") + std::to_string(cpus[i]);
+                    if (j > i) {
+                        result += "-" + std::to_string(cpus[j]);
+                    }
+                    i = j + 1;
+                }
+                return result;
+            }
+
+            inline std::optional<std::vector<int>> read_cpu_list_file(const std::string& path) {
+                std::ifstream file(path);
+                std::string list;
+                if (!file || !std::getline(file, list)) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to read " << path;
+                    return std::nullopt;
+                }
+                return parse_cpu_list(list);
+            }
+
+            inline bool set_memory_policy(int mode, const std::vector<int>& nodes) {
+                unsigned long mask[max_numa_nodes / (8 * sizeof(unsigned long))] = {};
+                for (int node : nodes) {
+                    if (node < 0 || static_cast<std::size_t>(node) >= max_numa_nodes) {
+                        return false;
+                    }
+                    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+                }
+                return ::syscall(SYS_set_mempolicy, mode, mask, max_numa_nodes + 1) == 0;
+            }
+        } // namespace detail
+
+        struct ThreadPlacementOptions {
+            // 0 means all CPUs allowed.
+            std::size_t cpus = 0;
+            // Kernel cpu list format, empty means the CPUs the process was started on.
+            std::string cpu_affinity;
+            // Negative means no binding.
+            int numa_node = -1;
+            bool numa_interleave = false;
+        };
+
+        struct ThreadPlacement {
+            std::vector<int> cpus;
+            std::string memory_policy;
+        };
+
+        // Restricts the process to the requested CPUs and sets its memory policy. Must run before any worker
+        // threads are started, so that they inherit both. --cpus picks the first CPUs of the allowed set.
+        inline std::optional<ThreadPlacement> apply_thread_placement(const ThreadPlacementOptions& options) {
+            if (options.numa_node >= 0 && options.numa_interleave) {
+                BOOST_LOG_TRIVIAL(error) << "NUMA node binding and interleaving are mutually exclusive";
+                return std::nullopt;
+            }
+
+            cpu_set_t current_set;
+            CPU_ZERO(&current_set);
+            if (::sched_getaffinity(0, sizeof(current_set), &current_set) != 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to get CPU affinity: " << std::strerror(errno);
+                return std::nullopt;
+            }
+            std::vector<int> current_cpus;
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &current_set)) {
+                    current_cpus.push_back(cpu);
+                }
+            }
+
+            ThreadPlacement placement;
+            placement.cpus = current_cpus;
+            if (!options.cpu_affinity.empty()) {
+                auto cpus = detail::parse_cpu_list(options.cpu_affinity);
+                if (!cpus) {
+                    BOOST_LOG_TRIVIAL(error) << "Invalid CPU list: " << options.cpu_affinity;
+                    return std::nullopt;
+                }
+                // Only CPUs the process is allowed to run on, as sched_setaffinity would fail on the others.
+                std::vector<int> allowed_cpus;
+                std::set_intersection(
+                    current_cpus.begin(),
+                    current_cpus.end(),
+                    cpus->begin(),
+                    cpus->end(),
+                    std::back_inserter(allowed_cpus)
+                );
+                placement.cpus = std::move(allowed_cpus);
+            }
+            if (options.numa_node >= 0) {
+                auto node_cpus = detail::read_cpu_list_file(
+                    "/sys/devices/system/node/node" + std::to_string(options.numa_node) + "/cpulist"
+                );
+                if (!node_cpus) {
+                    BOOST_LOG_TRIVIAL(error) << "Unknown NUMA node " << options.numa_node;
+                    return std::nullopt;
+                }
+                std::vector<int> cpus;
+                std::set_intersection(
+                    placement.cpus.begin(),
+                    placement.cpus.end(),
+                    node_cpus->begin(),
+                    node_cpus->end(),
+                    std::back_inserter(cpus)
+                );
+                placement.cpus = std::move(cpus);
+            }
+            if (options.cpus != 0 && options.cpus < placement.cpus.size()) {
+                placement.cpus.resize(options.cpus);
+            }
+            if (placement.cpus.empty()) {
+                BOOST_LOG_TRIVIAL(error) << "No CPUs left to run on with the requested affinity";
+                return std::nullopt;
+            }
+
+            if (placement.cpus != current_cpus) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (int cpu : placement.cpus) {
+                    if (cpu >= CPU_SETSIZE) {
+                        BOOST_LOG_TRIVIAL(error) << "CPU " << cpu << " is out of range";
+                        return std::nullopt;
+                    }
+                    CPU_SET(cpu, &set);
+                }
+                if (::sched_setaffinity(0, sizeof(set), &set) != 0) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to set CPU affinity to "
+                                             << detail::format_cpu_list(placement.cpus) << ": "
+                                             << std::strerror(errno);
+                    return std::nullopt;
+                }
+            }
+
+            placement.memory_policy = "default";
+            if (options.numa_node >= 0) {
+                if (!detail::set_memory_policy(detail::mpol_bind, {options.numa_node})) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to bind memory to NUMA node " << options.numa_node << ": "
+                                             << std::strerror(errno);
+                    return std::nullopt;
+                }
+                placement.memory_policy = "bind:" + std::to_string(options.numa_node);
+            } else if (options.numa_interleave) {
+                auto nodes = detail::read_cpu_list_file("/sys/devices/system/node/online");
+                if (!nodes || !detail::set_memory_policy(detail::mpol_interleave, *nodes)) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to interleave memory over NUMA nodes: " << std::strerror(errno);
+                    return std::nullopt;
+                }
+                placement.memory_policy = "interleave:" + detail::format_cpu_list(*nodes);
+            }
+
+            BOOST_LOG_TRIVIAL(info) << "Running on " << placement.cpus.size() << " CPUs "
+                                    << detail::format_cpu_list(placement.cpus) << ", memory policy "
+                                    << placement.memory_policy;
+            return placement;
+        }
+
+    } // namespace proof_generator
+} // namespace nil
+
+#endif // PROOF_GENERATOR_THREAD_PLACEMENT_HPP
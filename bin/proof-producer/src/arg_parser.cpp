@@ -17,10 +17,13 @@
 #include "nil/proof-generator/arg_parser.hpp"
 
 #include "nil/proof-generator/arithmetization_params.hpp"
+#include "nil/proof-generator/cost_model.hpp"
 
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 
@@ -73,26 +76,76 @@ namespace nil {
             // clang-format off
             auto options_appender = config.add_options()
                 ("stage", make_defaulted_option(prover_options.stage),
-                 "Stage of the prover to run, one of (all, preprocess, prove, verify, generate-aggregated-challenge). Defaults to 'all'.")
-                ("proof,p", make_defaulted_option(prover_options.proof_file_path), "Proof file")
+                 "Stage of the prover to run, one of (all, preprocess, prove, verify, generate-aggregated-challenge, serve, prove-batch, convert-table, estimate). Defaults to 'all'.")
+                ("proof,p", make_defaulted_option(prover_options.proof_file_path), "Proof file, \"-\" for the standard output")
+                ("proof-fd", make_defaulted_option(prover_options.proof_fd),
+                 "Descriptor to write the proof to instead of the proof file, -1 for none")
+                ("proof-format", make_defaulted_option(prover_options.proof_format), "Proof file format (hex, binary)")
                 ("json,j", make_defaulted_option(prover_options.json_file_path), "JSON proof file")
+                ("no-json", po::bool_switch(&prover_options.no_json), "Don't write the JSON proof file")
+                ("async-write", po::bool_switch(&prover_options.async_write),
+                 "Write output files from a background thread, overlapping encoding with the disk writes")
+                ("compression-level", make_defaulted_option(prover_options.compression_level),
+                 "zstd level (1-19) for preprocessed data and commitment state files, 0 for no compression. Compressed inputs are detected automatically")
                 ("common-data", make_defaulted_option(prover_options.preprocessed_common_data_path), "Preprocessed common data file")
                 ("preprocessed-data", make_defaulted_option(prover_options.preprocessed_public_data_path), "Preprocessed public data file")
                 ("commitment-state-file", make_defaulted_option(prover_options.commitment_scheme_state_path), "Commitment state data file")
-                ("circuit", po::value(&prover_options.circuit_file_path), "Circuit input file")
-                ("assignment-table,t", po::value(&prover_options.assignment_table_file_path), "Assignment table input file")
+                ("circuit", po::value(&prover_options.circuit_file_path), "Circuit input file, \"-\" for the standard input")
+                ("assignment-table,t", po::value(&prover_options.assignment_table_file_path), "Assignment table input file, \"-\" for the standard input")
                 ("assignment-description-file", po::value(&prover_options.assignment_description_file_path), "Assignment description file")
+                ("indexed-assignment-table", make_defaulted_option(prover_options.indexed_assignment_table_file_path),
+                 "Indexed assignment table output file. Used with 'convert-table' stage")
+                ("cost-model", po::value(&prover_options.cost_model_file_path),
+                 "Cost model fitted by tests/fit_cost_model.sh, built-in defaults if not set. Used with 'estimate' stage and --auto-params")
+                ("estimate-out", po::value(&prover_options.estimate_file_path),
+                 "JSON file to write the resource estimate to, standard output if not set. Used with 'estimate' stage")
+                ("metrics-out", po::value(&prover_options.metrics_file_path),
+                 "JSON file to write wall time, CPU time, peak RSS and I/O of every step to")
+                ("trace-out", po::value(&prover_options.trace_file_path),
+                 "File to write the spans of the steps and file operations to, in Chrome trace event format")
+                ("counters-out", po::value(&prover_options.counters_file_path),
+                 "File to write the work counters to, in Prometheus text format. Only in builds with PROOF_GENERATOR_COUNTERS_ENABLED")
                 ("log-level,l", make_defaulted_option(prover_options.log_level), "Log level (trace, debug, info, warning, error, fatal)")
                 ("elliptic-curve-type,e", make_defaulted_option(prover_options.elliptic_curve_type), "Elliptic curve type (pallas)")
                 ("hash-type", make_defaulted_option(prover_options.hash_type), "Hash type (keccak, poseidon, sha256)")
                 ("lambda-param", make_defaulted_option(prover_options.lambda), "Lambda param (9)")
-                ("grind-param", make_defaulted_option(prover_options.grind), "Grind param (69)")
+                ("grind-param", make_defaulted_option(prover_options.grind),
+                 "Proof of work bits before the FRI queries, 0 disables grinding. Every bit adds a bit of security to the queries at the cost of doubling the grinding time, which runs on a single thread")
                 ("expand-factor,x", make_defaulted_option(prover_options.expand_factor), "Expand factor")
                 ("max-quotient-chunks,q", make_defaulted_option(prover_options.max_quotient_chunks), "Maximum quotient polynomial parts amount")
+                ("auto-params", po::value(&prover_options.auto_params),
+                 "Choose lambda, expand factor and max quotient chunks minimizing one of (latency, memory, proof-size) by the cost model, in place of the given ones. Pass the same value to every stage of a proof")
+                ("security-bits", make_defaulted_option(prover_options.security_bits),
+                 "Conjectured security (lambda * expand factor + grind bits) --auto-params must keep, 0 for the one of the given parameters")
                 ("input-challenge-files,u", po::value<std::vector<boost::filesystem::path>>(&prover_options.input_challenge_files)->multitoken(),
                  "Input challenge files. Used with 'generate-aggregated-challenge' stage.")
+                ("input-challenges-packed-file", po::value(&prover_options.packed_input_challenges_file),
+                 "File with concatenated input challenges, absorbed after the input challenge files. Used with 'generate-aggregated-challenge' stage.")
+                ("io-threads", make_defaulted_option(prover_options.io_threads), "Maximum amount of concurrent input file reads")
+                ("cpus", make_defaulted_option(prover_options.thread_placement.cpus),
+                 "Amount of CPUs to run on, 0 for all of the allowed ones. The producer's own pools are sized to it, the prover's actor pool keeps its own size and shares these CPUs")
+                ("threads", po::value<std::size_t>(), "Alias of --cpus, kept for existing scripts")
+                ("cpu-affinity", po::value(&prover_options.thread_placement.cpu_affinity),
+                 "CPUs to run on, e.g. 0-7,16-23")
+                ("numa-node", make_defaulted_option(prover_options.thread_placement.numa_node),
+                 "NUMA node to run on and allocate memory from, -1 for no binding")
+                ("numa-interleave", po::bool_switch(&prover_options.thread_placement.numa_interleave),
+                 "Interleave memory over all NUMA nodes")
+                ("memory-limit", make_defaulted_option(prover_options.memory_limit),
+                 "Resident memory in bytes above which large allocations are backed by a scratch file, 0 for no limit")
+                ("scratch-dir", po::value(&prover_options.scratch_dir),
+                 "Directory on disk for the scratch file of --memory-limit, system temp directory by default; "
+                 "tmpfs is rejected")
                 ("aggregated-challenge-file", po::value<boost::filesystem::path>(&prover_options.aggregated_challenge_file),
-                 "Aggregated challenge file. Used with 'generate-aggregated-challenge' stage");
+                 "Aggregated challenge file. Used with 'generate-aggregated-challenge' stage")
+                ("socket", make_defaulted_option(prover_options.socket_path),
+                 "Unix socket to accept prove jobs on. Used with 'serve' stage")
+                ("jobs-manifest", po::value(&prover_options.jobs_manifest_path),
+                 "File with lines \"<assignment-table> <proof> [<json-proof>]\". Used with 'prove-batch' stage")
+                ("preprocess-cache", po::value(&prover_options.preprocess_cache_path),
+                 "Directory to cache preprocessed public data in, shared between runs. Disabled if not set")
+                ("preprocess-cache-size", make_defaulted_option(prover_options.preprocess_cache_max_size),
+                 "Preprocess cache size limit in bytes, least recently used entries are evicted above it. 0 for no limit");
 
             // clang-format on
             po::options_description cmdline_options("nil; Proof Producer");
@@ -147,12 +200,45 @@ namespace nil {
 
             try {
                 check_exclusive_options(vm, {"verification-only", "skip-verification"});
+                check_exclusive_options(vm, {"cpus", "threads"});
             } catch (const std::logic_error& e) {
                 std::cerr << e.what() << std::endl;
                 std::cout << cmdline_options << std::endl;
                 throw e;
             }
 
+            if (vm.count("threads")) {
+                prover_options.thread_placement.cpus = vm["threads"].as<std::size_t>();
+            }
+
+            if (!prover_options.auto_params.empty() && !tuning_objective_from_string(prover_options.auto_params)) {
+                std::cerr << "Auto params objective must be one of latency, memory, proof-size" << std::endl;
+                throw std::invalid_argument("Invalid auto params objective: " + prover_options.auto_params);
+            }
+
+            if (prover_options.grind > max_grind_bits) {
+                std::cerr << "Grind param must not exceed " << max_grind_bits << " bits" << std::endl;
+                throw std::invalid_argument("Invalid grind param: " + std::to_string(prover_options.grind));
+            }
+
+            if (prover_options.compression_level < 0 || prover_options.compression_level > max_compression_level) {
+                std::cerr << "Compression level must be 0 or from 1 to " << max_compression_level << std::endl;
+                throw std::invalid_argument("Invalid compression level: " +
+                                            std::to_string(prover_options.compression_level));
+            }
+
+#ifndef PROOF_GENERATOR_COUNTERS_ENABLED
+            if (!prover_options.counters_file_path.empty()) {
+                std::cerr << "Counters are not compiled in, rebuild with -DPROOF_GENERATOR_COUNTERS_ENABLED=ON"
+                          << std::endl;
+                throw std::invalid_argument("Counters output requested from a build without counters");
+            }
+#endif
+
+            if (prover_options.proof_fd >= 0) {
+                prover_options.proof_file_path = "/dev/fd/" + std::to_string(prover_options.proof_fd);
+            }
+
             return prover_options;
         }
 
@@ -213,5 +299,11 @@ namespace nil {
         GENERATE_READ_OPERATOR(HASH_TYPES, HashesVariant)
 #undef X
 
+        std::string hash_type_name(const HashesVariant& hash_type) {
+            std::ostringstream name;
+            name << hash_type;
+            return name.str();
+        }
+
     } // namespace proof_generator
 } // namespace nil
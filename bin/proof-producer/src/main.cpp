@@ -22,13 +22,56 @@
 #include <utility>
 
 #include <nil/proof-generator/arg_parser.hpp>
+#include <nil/proof-generator/counters.hpp>
 #include <nil/proof-generator/file_operations.hpp>
+#include <nil/proof-generator/memory_budget.hpp>
+#include <nil/proof-generator/metrics.hpp>
+#include <nil/proof-generator/parallel.hpp>
+#include <nil/proof-generator/preprocess_cache.hpp>
+#include <nil/proof-generator/prove_jobs.hpp>
 #include <nil/proof-generator/prover.hpp>
+#include <nil/proof-generator/prover_server.hpp>
+#include <nil/proof-generator/thread_placement.hpp>
 
 #undef B0
 
 using namespace nil::proof_generator;
 
+// Public data is preprocessed once with the first table of the batch, the rest of the tables reuse it.
+// Keeps going when a job fails, result is false if any of them did.
+template<typename ProverType>
+bool prove_batch(ProverType& prover, const std::vector<ProveJob>& jobs) {
+    const ProveJob& first_job = jobs.front();
+    std::size_t jobs_failed = 0;
+    if (!prover.preprocess_private_data() ||
+        !prover.generate_to_file(first_job.proof_file_path, first_job.json_file_path, true/*skip verification*/)) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to prove " << first_job.assignment_table_file_path;
+        ++jobs_failed;
+    }
+    for (std::size_t i = 1; i < jobs.size(); ++i) {
+        BOOST_LOG_TRIVIAL(info) << "Proving " << jobs[i].assignment_table_file_path
+                                << " (" << i + 1 << "/" << jobs.size() << ")";
+        if (!prover.prove_assignment_table_to_file(
+                jobs[i].assignment_table_file_path,
+                jobs[i].proof_file_path,
+                jobs[i].json_file_path,
+                true/*skip verification*/)) {
+            BOOST_LOG_TRIVIAL(error) << "Failed to prove " << jobs[i].assignment_table_file_path;
+            ++jobs_failed;
+        }
+    }
+    BOOST_LOG_TRIVIAL(info) << "Batch done, " << jobs.size() - jobs_failed << " of " << jobs.size() << " proofs generated";
+    return jobs_failed == 0;
+}
+
+// Loads the inputs of a stage concurrently, reported as one load_inputs step.
+template<typename... Tasks>
+bool load_inputs_concurrently(std::size_t io_threads, Tasks&&... tasks) {
+    nil::proof_generator::ScopedStep step("load_inputs");
+    nil::proof_generator::ConcurrentSteps concurrent_steps;
+    return nil::proof_generator::all_of_concurrently(io_threads, std::forward<Tasks>(tasks)...);
+}
+
 template<typename CurveType, typename HashType>
 int run_prover(const nil::proof_generator::ProverOptions& prover_options) {
     auto prover_task = [&] {
@@ -36,16 +79,41 @@ int run_prover(const nil::proof_generator::ProverOptions& prover_options) {
             prover_options.lambda,
             prover_options.expand_factor,
             prover_options.max_quotient_chunks,
-            prover_options.grind
+            prover_options.grind,
+            OutputOptions {
+                prover_options.proof_format,
+                !prover_options.no_json,
+                prover_options.async_write,
+                prover_options.compression_level
+            }
         );
+        std::optional<PreprocessCache> preprocess_cache;
+        if (!prover_options.preprocess_cache_path.empty()) {
+            preprocess_cache.emplace(prover_options.preprocess_cache_path, prover_options.preprocess_cache_max_size);
+        }
+        auto preprocess_public_data = [&prover, &preprocess_cache]() {
+            return preprocess_cache ? prover.preprocess_public_data_cached(*preprocess_cache)
+                                    : prover.preprocess_public_data();
+        };
+        auto tune_parameters = [&prover, &prover_options]() {
+            return prover_options.auto_params.empty() ||
+                   prover.tune_parameters(
+                       *nil::proof_generator::tuning_objective_from_string(prover_options.auto_params),
+                       prover_options.security_bits,
+                       prover_options.cost_model_file_path,
+                       nil::proof_generator::hash_type_name(prover_options.hash_type));
+        };
         bool prover_result;
         try {
             switch (nil::proof_generator::detail::prover_stage_from_string(prover_options.stage)) {
                 case nil::proof_generator::detail::ProverStage::ALL:
                     prover_result =
-                        prover.read_circuit(prover_options.circuit_file_path) &&
-                        prover.read_assignment_table(prover_options.assignment_table_file_path) &&
-                        prover.preprocess_public_data() &&
+                        load_inputs_concurrently(
+                            prover_options.io_threads,
+                            [&] { return prover.read_circuit(prover_options.circuit_file_path); },
+                            [&] { return prover.read_assignment_table(prover_options.assignment_table_file_path); }) &&
+                        tune_parameters() &&
+                        preprocess_public_data() &&
                         prover.preprocess_private_data() &&
                         prover.generate_to_file(
                             prover_options.proof_file_path,
@@ -57,21 +125,42 @@ int run_prover(const nil::proof_generator::ProverOptions& prover_options) {
                     break;
                 case nil::proof_generator::detail::ProverStage::PREPROCESS:
                     prover_result =
-                        prover.read_circuit(prover_options.circuit_file_path) &&
-                        prover.read_assignment_table(prover_options.assignment_table_file_path) &&
+                        load_inputs_concurrently(
+                            prover_options.io_threads,
+                            [&] { return prover.read_circuit(prover_options.circuit_file_path); },
+                            [&] {
+                                return prover.read_assignment_table(
+                                    prover_options.assignment_table_file_path,
+                                    nil::proof_generator::public_table_sections);
+                            }) &&
                         prover.save_assignment_description(prover_options.assignment_description_file_path) &&
-                        prover.preprocess_public_data() &&
+                        tune_parameters() &&
+                        preprocess_public_data() &&
                         prover.save_preprocessed_common_data_to_file(prover_options.preprocessed_common_data_path) &&
                         prover.save_public_preprocessed_data_to_file(prover_options.preprocessed_public_data_path) &&
                         prover.save_commitment_state_to_file(prover_options.commitment_scheme_state_path);
                     break;
                 case nil::proof_generator::detail::ProverStage::PROVE:
-                    // Load preprocessed data from file and generate the proof.
+                    // Load preprocessed data from file and generate the proof. The inputs are independent of each
+                    // other, so they are loaded concurrently.
                     prover_result =
-                        prover.read_circuit(prover_options.circuit_file_path) &&
-                        prover.read_assignment_table(prover_options.assignment_table_file_path) &&
-                        prover.read_public_preprocessed_data_from_file(prover_options.preprocessed_public_data_path) &&
-                        prover.read_commitment_scheme_from_file(prover_options.commitment_scheme_state_path) &&
+                        load_inputs_concurrently(
+                            prover_options.io_threads,
+                            [&] { return prover.read_circuit(prover_options.circuit_file_path); },
+                            [&] {
+                                return prover.read_assignment_table(
+                                    prover_options.assignment_table_file_path,
+                                    nil::proof_generator::proving_table_sections);
+                            },
+                            [&] {
+                                return prover.read_public_preprocessed_data_from_file(
+                                    prover_options.preprocessed_public_data_path);
+                            },
+                            [&] {
+                                return prover.read_commitment_scheme_from_file(
+                                    prover_options.commitment_scheme_state_path);
+                            }) &&
+                        tune_parameters() &&
                         prover.preprocess_private_data() &&
                         prover.generate_to_file(
                             prover_options.proof_file_path,
@@ -83,14 +172,67 @@ int run_prover(const nil::proof_generator::ProverOptions& prover_options) {
                         prover.read_circuit(prover_options.circuit_file_path) &&
                         prover.read_preprocessed_common_data_from_file(prover_options.preprocessed_common_data_path) &&
                         prover.read_assignment_description(prover_options.assignment_description_file_path) &&
+                        tune_parameters() &&
                         prover.verify_from_file(prover_options.proof_file_path);
                     break;
                 case nil::proof_generator::detail::ProverStage::GENERATE_AGGREGATED_CHALLENGE:
                     prover_result =
                         prover.generate_aggregated_challenge_to_file(
                             prover_options.input_challenge_files,
-                            prover_options.aggregated_challenge_file
+                            prover_options.packed_input_challenges_file,
+                            prover_options.aggregated_challenge_file,
+                            prover_options.io_threads
                         );
+                    break;
+                case nil::proof_generator::detail::ProverStage::SERVE:
+                    // Load the circuit and its preprocessed data once, then prove every table sent to the socket.
+                    prover_result =
+                        prover.read_circuit(prover_options.circuit_file_path) &&
+                        prover.read_assignment_description(prover_options.assignment_description_file_path) &&
+                        prover.read_public_preprocessed_data_from_file(prover_options.preprocessed_public_data_path) &&
+                        prover.read_commitment_scheme_from_file(prover_options.commitment_scheme_state_path) &&
+                        tune_parameters() &&
+                        prover.snapshot_preprocessed_state() &&
+                        nil::proof_generator::serve_prove_jobs(
+                            prover,
+                            prover_options.socket_path,
+                            true/*skip verification*/);
+                    break;
+                case nil::proof_generator::detail::ProverStage::PROVE_BATCH: {
+                    auto jobs = nil::proof_generator::read_prove_jobs_manifest(prover_options.jobs_manifest_path);
+                    prover_result =
+                        jobs.has_value() &&
+                        prover.read_circuit(prover_options.circuit_file_path) &&
+                        prover.read_assignment_table(jobs->front().assignment_table_file_path) &&
+                        tune_parameters() &&
+                        (prover_options.assignment_description_file_path.empty() ||
+                            prover.save_assignment_description(prover_options.assignment_description_file_path)) &&
+                        preprocess_public_data() &&
+                        prover.save_preprocessed_common_data_to_file(prover_options.preprocessed_common_data_path) &&
+                        prover.snapshot_preprocessed_state() &&
+                        prove_batch(prover, *jobs);
+                    break;
+                }
+                case nil::proof_generator::detail::ProverStage::CONVERT_TABLE:
+                    prover_result =
+                        prover.read_assignment_table(prover_options.assignment_table_file_path) &&
+                        prover.save_indexed_assignment_table(prover_options.indexed_assignment_table_file_path);
+                    break;
+                case nil::proof_generator::detail::ProverStage::ESTIMATE:
+                    prover_result =
+                        load_inputs_concurrently(
+                            prover_options.io_threads,
+                            [&] { return prover.read_circuit(prover_options.circuit_file_path); },
+                            [&] {
+                                return prover.read_assignment_description(
+                                    prover_options.assignment_description_file_path);
+                            }) &&
+                        tune_parameters() &&
+                        prover.estimate_resources(
+                            prover_options.cost_model_file_path,
+                            nil::proof_generator::hash_type_name(prover_options.hash_type),
+                            prover_options.estimate_file_path);
+                    break;
             }
         } catch (const std::exception& e) {
             BOOST_LOG_TRIVIAL(error) << e.what();
@@ -126,7 +268,60 @@ int curve_wrapper(const ProverOptions& prover_options) {
 }
 
 int initial_wrapper(const ProverOptions& prover_options) {
-    return curve_wrapper(prover_options);
+    if (!prover_options.trace_file_path.empty()) {
+        Tracer::instance().enable();
+    }
+    Metrics& metrics = Metrics::instance();
+    metrics.set_info("stage", prover_options.stage);
+    metrics.set_info("hash_type", hash_type_name(prover_options.hash_type));
+    metrics.set_info("lambda", std::to_string(prover_options.lambda));
+    metrics.set_info("expand_factor", std::to_string(prover_options.expand_factor));
+    metrics.set_info("max_quotient_chunks", std::to_string(prover_options.max_quotient_chunks));
+    metrics.set_info("grind", std::to_string(prover_options.grind));
+    if (!prover_options.auto_params.empty()) {
+        metrics.set_info("auto_params", prover_options.auto_params);
+    }
+
+    // Before anything starts threads, so that they inherit the placement.
+    auto thread_placement = apply_thread_placement(prover_options.thread_placement);
+    if (!thread_placement) {
+        return 1;
+    }
+    metrics.set_info("cpus", std::to_string(thread_placement->cpus.size()));
+    metrics.set_info("cpu_affinity", detail::format_cpu_list(thread_placement->cpus));
+    metrics.set_info("memory_policy", thread_placement->memory_policy);
+
+    if (prover_options.memory_limit != 0) {
+        boost::filesystem::path scratch_dir = prover_options.scratch_dir.empty()
+                                                  ? boost::filesystem::temp_directory_path()
+                                                  : prover_options.scratch_dir;
+        if (!enable_memory_budget(prover_options.memory_limit, scratch_dir.string())) {
+            return 1;
+        }
+        metrics.set_info("memory_limit", std::to_string(prover_options.memory_limit));
+    }
+
+    int ret = curve_wrapper(prover_options);
+    if (prover_options.memory_limit != 0) {
+        metrics.set_info("spilled_bytes_peak", std::to_string(spilled_bytes_peak()));
+    }
+    // Reports that were asked for and could not be written fail the run.
+    if (!prover_options.metrics_file_path.empty() &&
+        !metrics.write_json(prover_options.metrics_file_path, ret == 0)) {
+        ret = 1;
+    }
+    if (!prover_options.trace_file_path.empty() &&
+        !Tracer::instance().write_chrome_trace(prover_options.trace_file_path)) {
+        ret = 1;
+    }
+    if (!prover_options.counters_file_path.empty() &&
+        !Counters::write_prometheus(
+            prover_options.counters_file_path,
+            {{"stage", prover_options.stage}, {"hash_type", hash_type_name(prover_options.hash_type)}}
+        )) {
+        ret = 1;
+    }
+    return ret;
 }
 
 int main(int argc, char* argv[]) {
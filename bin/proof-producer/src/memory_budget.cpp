@@ -0,0 +1,394 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+// Replaces the global operator new and delete to implement the memory budget. Polynomials, columns and
+// Merkle trees of crypto3 are std::vectors with the default allocator, so this is the only way to reach them without
+// changes to the library. Blocks under spill_threshold are never accounted nor spilled: the replacement costs them a
+// branch on allocation and an address range check on delete.
+//
+// With the budget enabled, a large allocation is spilled when the anonymous resident memory of the process would
+// grow over the limit with it. All spilled blocks live in one scratch file, mapped once over an address range
+// reserved at start, so the process gets a single mapping however many blocks spill, and delete tells spilled blocks
+// from heap ones by their address. Every block is preceded by a header page holding its size. The file range of a
+// freed block is punched out, which drops its pages and disk blocks, and the range is reused.
+
+#include <nil/proof-generator/memory_budget.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+namespace nil {
+    namespace proof_generator {
+        namespace {
+            // Smaller allocations always stay on the heap.
+            constexpr std::size_t spill_threshold = std::size_t(1) << 20;
+            constexpr std::size_t reserved_range_size = std::size_t(16) << 40;
+            constexpr std::size_t max_free_extents = 4096;
+
+            struct Extent {
+                char* begin;
+                std::size_t size;
+            };
+
+            std::atomic<bool> budget_enabled {false};
+            std::size_t budget_limit = 0;
+            std::size_t page_size = 4096;
+            int scratch_fd = -1;
+
+            std::atomic<std::size_t> spilled_in_use {0};
+            std::atomic<std::size_t> spilled_peak {0};
+
+            std::atomic<char*> range_begin {nullptr};
+            std::atomic<char*> range_end {nullptr};
+
+            // Free list and never used tail of the reserved range, the file is as long as the used part of it.
+            // Plain arrays, as nothing here may allocate.
+            std::mutex range_mutex;
+            char* range_unused = nullptr;
+            Extent free_extents[max_free_extents];
+            std::size_t free_extents_amount = 0;
+
+            bool is_spilled(void* pointer) {
+                char* begin = range_begin.load(std::memory_order_relaxed);
+                return begin != nullptr && static_cast<char*>(pointer) >= begin &&
+                       static_cast<char*>(pointer) < range_end.load(std::memory_order_relaxed);
+            }
+
+            // RssAnon of /proc/self/status, read without allocating. Spilled pages are file backed and don't count.
+            std::size_t anonymous_resident_bytes() {
+                int fd = ::open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return 0;
+                }
+                char buffer[4096];
+                ssize_t size = ::read(fd, buffer, sizeof(buffer) - 1);
+                ::close(fd);
+                if (size <= 0) {
+                    return 0;
+                }
+                buffer[size] = '\0';
+                const char* line = std::strstr(buffer, "RssAnon:");
+                if (line == nullptr) {
+                    return 0;
+                }
+                return std::strtoull(line + std::strlen("RssAnon:"), nullptr, 10) * 1024;
+            }
+
+            char* reserve_extent(std::size_t size) {
+                std::lock_guard<std::mutex> lock(range_mutex);
+                for (std::size_t i = 0; i < free_extents_amount; ++i) {
+                    Extent& extent = free_extents[i];
+                    if (extent.size >= size) {
+                        char* begin = extent.begin;
+                        extent.begin += size;
+                        extent.size -= size;
+                        if (extent.size == 0) {
+                            extent = free_extents[--free_extents_amount];
+                        }
+                        return begin;
+                    }
+                }
+                if (static_cast<std::size_t>(range_end.load(std::memory_order_relaxed) - range_unused) < size) {
+                    return nullptr;
+                }
+                // Pages of the mapping past the end of the file can't be accessed, grow the file first.
+                char* begin = range_unused;
+                if (::ftruncate(scratch_fd, begin + size - range_begin.load(std::memory_order_relaxed)) != 0) {
+                    return nullptr;
+                }
+                range_unused += size;
+                return begin;
+            }
+
+            void release_extent(char* begin, std::size_t size) {
+                ::fallocate(
+                    scratch_fd,
+                    FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                    begin - range_begin.load(std::memory_order_relaxed),
+                    size
+                );
+                std::lock_guard<std::mutex> lock(range_mutex);
+                for (std::size_t i = 0; i < free_extents_amount; ++i) {
+                    Extent& extent = free_extents[i];
+                    if (extent.begin + extent.size == begin) {
+                        extent.size += size;
+                        return;
+                    }
+                    if (begin + size == extent.begin) {
+                        extent.begin = begin;
+                        extent.size += size;
+                        return;
+                    }
+                }
+                if (free_extents_amount < max_free_extents) {
+                    free_extents[free_extents_amount++] = {begin, size};
+                }
+                // Otherwise the range is lost for reuse, its file range stays a hole.
+            }
+
+            int open_scratch_file(const std::string& scratch_dir) {
+                int fd = ::open(scratch_dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+                if (fd >= 0) {
+                    return fd;
+                }
+                // Filesystems without O_TMPFILE support.
+                char path[PATH_MAX];
+                int length = std::snprintf(path, sizeof(path), "%s/proof-producer-scratch-XXXXXX", scratch_dir.c_str());
+                if (length < 0 || length >= static_cast<int>(sizeof(path))) {
+                    return -1;
+                }
+                fd = ::mkostemp(path, O_CLOEXEC);
+                if (fd >= 0) {
+                    ::unlink(path);
+                }
+                return fd;
+            }
+
+            void* spill_allocate(std::size_t size, std::size_t alignment) {
+                if (alignment > page_size) {
+                    return nullptr;
+                }
+                std::size_t total = (size + 2 * page_size - 1) / page_size * page_size;
+                char* begin = reserve_extent(total);
+                if (begin == nullptr) {
+                    return nullptr;
+                }
+
+                *reinterpret_cast<std::size_t*>(begin) = total;
+                std::size_t in_use = spilled_in_use.fetch_add(total, std::memory_order_relaxed) + total;
+                std::size_t peak = spilled_peak.load(std::memory_order_relaxed);
+                while (in_use > peak &&
+                       !spilled_peak.compare_exchange_weak(peak, in_use, std::memory_order_relaxed)) {
+                }
+                return begin + page_size;
+            }
+
+            void spill_free(void* pointer) {
+                char* begin = static_cast<char*>(pointer) - page_size;
+                std::size_t total = *reinterpret_cast<std::size_t*>(begin);
+                release_extent(begin, total);
+                spilled_in_use.fetch_sub(total, std::memory_order_relaxed);
+            }
+
+            void* allocate(std::size_t size, std::size_t alignment) {
+                if (size >= spill_threshold && budget_enabled.load(std::memory_order_acquire) &&
+                    anonymous_resident_bytes() + size > budget_limit) {
+                    if (void* pointer = spill_allocate(size, alignment)) {
+                        return pointer;
+                    }
+                }
+
+                void* pointer = nullptr;
+                if (alignment > alignof(std::max_align_t)) {
+                    if (::posix_memalign(&pointer, alignment, size == 0 ? 1 : size) != 0) {
+                        pointer = nullptr;
+                    }
+                } else {
+                    pointer = std::malloc(size == 0 ? 1 : size);
+                }
+                return pointer;
+            }
+
+            void* allocate_or_throw(std::size_t size, std::size_t alignment) {
+                while (true) {
+                    if (void* pointer = allocate(size, alignment)) {
+                        return pointer;
+                    }
+                    std::new_handler handler = std::get_new_handler();
+                    if (handler == nullptr) {
+                        throw std::bad_alloc();
+                    }
+                    handler();
+                }
+            }
+
+            void deallocate(void* pointer) {
+                if (pointer == nullptr) {
+                    return;
+                }
+                if (is_spilled(pointer)) {
+                    spill_free(pointer);
+                    return;
+                }
+                std::free(pointer);
+            }
+        } // namespace
+
+        bool enable_memory_budget(std::size_t limit_bytes, const std::string& scratch_dir) {
+            if (budget_enabled.load()) {
+                BOOST_LOG_TRIVIAL(error) << "Memory budget is already set";
+                return false;
+            }
+            struct statfs filesystem;
+            if (::statfs(scratch_dir.c_str(), &filesystem) != 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to use scratch directory " << scratch_dir << ": "
+                                         << std::strerror(errno);
+                return false;
+            }
+            if (filesystem.f_type == TMPFS_MAGIC || filesystem.f_type == RAMFS_MAGIC) {
+                BOOST_LOG_TRIVIAL(error) << "Scratch directory " << scratch_dir
+                                         << " is in memory, spilling there would not free any. Pass a directory on "
+                                            "disk with --scratch-dir";
+                return false;
+            }
+            page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            scratch_fd = open_scratch_file(scratch_dir);
+            if (scratch_fd < 0) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to create a scratch file in " << scratch_dir << ": "
+                                         << std::strerror(errno);
+                return false;
+            }
+
+            // The file grows as blocks are spilled, the mapping covers its largest possible size from the start.
+            void* range = ::mmap(
+                nullptr,
+                reserved_range_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_NORESERVE,
+                scratch_fd,
+                0
+            );
+            if (range == MAP_FAILED) {
+                BOOST_LOG_TRIVIAL(error) << "Unable to reserve address space for the scratch file: "
+                                         << std::strerror(errno);
+                ::close(scratch_fd);
+                scratch_fd = -1;
+                return false;
+            }
+            range_unused = static_cast<char*>(range);
+            range_end.store(static_cast<char*>(range) + reserved_range_size);
+            range_begin.store(static_cast<char*>(range));
+            budget_limit = limit_bytes;
+            budget_enabled.store(true, std::memory_order_release);
+
+            BOOST_LOG_TRIVIAL(info) << "Memory budget is " << limit_bytes << " bytes, allocations over it go to "
+                                    << scratch_dir;
+            return true;
+        }
+
+        std::size_t heap_bytes_in_use() {
+            return anonymous_resident_bytes();
+        }
+
+        std::size_t spilled_bytes_in_use() {
+            return spilled_in_use.load(std::memory_order_relaxed);
+        }
+
+        std::size_t spilled_bytes_peak() {
+            return spilled_peak.load(std::memory_order_relaxed);
+        }
+
+    } // namespace proof_generator
+} // namespace nil
+
+using nil::proof_generator::allocate;
+using nil::proof_generator::allocate_or_throw;
+using nil::proof_generator::deallocate;
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(pointer);
+}
@@ -0,0 +1,115 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Iosif (x-mass) <x-mass@nil.foundation>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//---------------------------------------------------------------------------//
+
+// Writes a synthetic circuit and its assignment table in the format produced by the assigner,
+// see synthetic_circuit.hpp for the shape of the circuit.
+
+#include <iostream>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/program_options.hpp>
+
+#include <nil/crypto3/algebra/curves/pallas.hpp>
+#include <nil/crypto3/marshalling/zk/types/plonk/assignment_table.hpp>
+#include <nil/crypto3/marshalling/zk/types/plonk/constraint_system.hpp>
+
+#include <nil/proof-generator/prover.hpp>
+#include <nil/proof-generator/synthetic_circuit.hpp>
+
+#undef B0
+
+using namespace nil::proof_generator;
+
+namespace po = boost::program_options;
+
+int main(int argc, char* argv[]) {
+    // Circuits are bound to the field, the producer supports pallas only.
+    using BlueprintField = nil::crypto3::algebra::curves::pallas::base_field_type;
+    using Generator = SyntheticCircuit<BlueprintField>;
+    using Endianness = nil::marshalling::option::big_endian;
+
+    SyntheticCircuitOptions options;
+    boost::filesystem::path circuit_file_path = "circuit.crct";
+    boost::filesystem::path assignment_table_file_path = "assignment.tbl";
+
+    po::options_description description("Nil; Synthetic circuit generator options");
+    // clang-format off
+    description.add_options()
+        ("help,h", "Produce help message")
+        ("circuit", po::value(&circuit_file_path)->default_value(circuit_file_path), "Circuit output file")
+        ("assignment-table,t", po::value(&assignment_table_file_path)->default_value(assignment_table_file_path),
+         "Assignment table output file")
+        ("rows-log", po::value(&options.rows_log)->default_value(options.rows_log),
+         "Log2 of the table rows amount, from 10 to 22")
+        ("witness-columns", po::value(&options.witness_columns)->default_value(options.witness_columns),
+         "Witness columns amount")
+        ("public-input-columns", po::value(&options.public_input_columns)->default_value(options.public_input_columns),
+         "Public input columns amount")
+        ("constant-columns", po::value(&options.constant_columns)->default_value(options.constant_columns),
+         "Constant columns amount")
+        ("selector-columns", po::value(&options.selector_columns)->default_value(options.selector_columns),
+         "Selector columns amount, one gate per selector")
+        ("gate-degree", po::value(&options.gate_degree)->default_value(options.gate_degree), "Degree of every gate")
+        ("seed", po::value(&options.seed)->default_value(options.seed), "Seed of the witness values");
+    // clang-format on
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, description), vm);
+        if (vm.count("help")) {
+            std::cout << description << std::endl;
+            return 0;
+        }
+        po::notify(vm);
+    } catch (const po::error& e) {
+        std::cerr << e.what() << std::endl;
+        std::cout << description << std::endl;
+        return 1;
+    }
+
+    if (auto problem = Generator::check_options(options)) {
+        BOOST_LOG_TRIVIAL(error) << "Invalid circuit shape: " << *problem;
+        return 1;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Writing circuit to " << circuit_file_path;
+    auto constraint_system = Generator::make_constraint_system(options);
+    if (!detail::encode_marshalling_to_file(
+            circuit_file_path,
+            nil::crypto3::marshalling::types::fill_plonk_constraint_system<Endianness, Generator::ConstraintSystem>(
+                constraint_system
+            )
+        )) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write circuit";
+        return 1;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Writing assignment table of 2^" << options.rows_log << " rows to "
+                            << assignment_table_file_path;
+    auto [table_description, assignment_table] = Generator::make_assignment_table(options);
+    if (!detail::encode_marshalling_to_file(
+            assignment_table_file_path,
+            nil::crypto3::marshalling::types::fill_assignment_table<Endianness, Generator::AssignmentTable>(
+                table_description.usable_rows_amount,
+                assignment_table
+            )
+        )) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write assignment table";
+        return 1;
+    }
+    return 0;
+}
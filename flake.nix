@@ -41,6 +41,7 @@
                 cmake
                 ninja
                 pkg-config
+                zstd
                 (if custom-boost == null then crypto3.packages.${system}.crypto3 else crypto3-with-custom-boost)
                 (if custom-boost == null then parallel-crypto3.packages.${system}.default else parallel-crypto3-with-custom-boost)
               ];
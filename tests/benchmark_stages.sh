@@ -0,0 +1,147 @@
+#!/bin/bash
+
+# Times every prover step on synthetic circuits for each hash type and both executables.
+# Per-run metrics are kept as <output-dir>/<executable>/<hash>/rows_<log>/<stage>.json,
+# and all the steps are collected into <output-dir>/summary.csv. The estimates of every run are kept next to the
+# metrics as resource_estimate.json, for tests/fit_cost_model.sh to calibrate the cost model with.
+
+color_red() { echo -e "\033[31m$1\033[0m"; }
+color_green() { echo -e "\033[32m$1\033[0m"; }
+
+get_script_dir() {
+    echo "$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+}
+
+parse_args() {
+    bin_dir="${script_dir}/../build/bin/proof-producer"
+    output_dir="benchmark"
+    rows_logs=(10 12 14 16)
+    hashes=(keccak sha256 poseidon)
+    executables=(single-threaded multi-threaded)
+    generator_args=()
+    args_to_forward=()
+
+    while [ "$#" -gt 0 ]; do
+        case "$1" in
+            --bin-dir)
+                bin_dir="$2"
+                shift 2
+                ;;
+            --output-dir)
+                output_dir="$2"
+                shift 2
+                ;;
+            --rows-logs)
+                read -r -a rows_logs <<< "$2"
+                shift 2
+                ;;
+            --hashes)
+                read -r -a hashes <<< "$2"
+                shift 2
+                ;;
+            --executables)
+                read -r -a executables <<< "$2"
+                shift 2
+                ;;
+            --generator-args)
+                read -r -a generator_args <<< "$2"
+                shift 2
+                ;;
+            --)
+                shift
+                while [ "$#" -gt 0 ]; do
+                    args_to_forward+=("$1")  # Passed to every prover call
+                    shift
+                done
+                ;;
+            *)
+                echo "Unknown argument $1"
+                exit 1
+                ;;
+        esac
+    done
+}
+
+# Prints "<stage>,<step>,<wall>,<cpu>,<peak rss>,<bytes read>,<bytes written>" for every step of a metrics file.
+# Relies on every step being written on its own line.
+steps_to_csv() {
+    local stage=$1
+    local metrics_file=$2
+    awk -v stage="$stage" '
+        function field(line, name,    value) {
+            value = line
+            sub(".*\"" name "\": ", "", value)
+            sub("[,}].*", "", value)
+            gsub("\"", "", value)
+            return value
+        }
+        /"name": / {
+            print stage "," field($0, "name") "," field($0, "wall_seconds") "," field($0, "cpu_seconds") "," \
+                field($0, "peak_rss_bytes") "," field($0, "bytes_read") "," field($0, "bytes_written")
+        }' "$metrics_file"
+}
+
+run_stage() {
+    local stage=$1
+    shift
+    local metrics_file="${run_dir}/${stage}.json"
+    echo -n "${executable} ${hash} 2^${rows_log} ${stage}: "
+    if "$prover_binary" --stage="$stage" --hash-type="$hash" --metrics-out="$metrics_file" \
+        "$@" "${args_to_forward[@]}" > "${run_dir}/${stage}.log" 2>&1; then
+        color_green "success"
+    else
+        color_red "failed, see ${run_dir}/${stage}.log"
+        exit_code=1
+        return 1
+    fi
+    steps_to_csv "$stage" "$metrics_file" | sed "s/^/${executable},${hash},${rows_log},/" >> "$summary_file"
+}
+
+exit_code=0
+script_dir=$(get_script_dir)
+parse_args "$@"
+
+generator_binary="${bin_dir}/proof-producer-synthetic-generator"
+mkdir -p "$output_dir"
+summary_file="${output_dir}/summary.csv"
+echo "executable,hash,rows_log,stage,step,wall_seconds,cpu_seconds,peak_rss_bytes,bytes_read,bytes_written" > "$summary_file"
+
+for rows_log in "${rows_logs[@]}"; do
+    circuit_dir="${output_dir}/circuits/rows_${rows_log}"
+    mkdir -p "$circuit_dir"
+    if ! "$generator_binary" --rows-log="$rows_log" --circuit="${circuit_dir}/circuit.crct" \
+        --assignment-table="${circuit_dir}/assignment.tbl" "${generator_args[@]}"; then
+        color_red "Failed to generate circuit with 2^${rows_log} rows"
+        exit_code=1
+        continue
+    fi
+
+    for executable in "${executables[@]}"; do
+        prover_binary="${bin_dir}/proof-producer-${executable}"
+        for hash in "${hashes[@]}"; do
+            run_dir="${output_dir}/${executable}/${hash}/rows_${rows_log}"
+            mkdir -p "$run_dir"
+            circuit_args=(--circuit="${circuit_dir}/circuit.crct")
+            preprocessed_args=(
+                --common-data="${run_dir}/preprocessed_common_data.dat"
+                --preprocessed-data="${run_dir}/preprocessed.dat"
+                --commitment-state-file="${run_dir}/commitment_state.dat"
+            )
+            run_stage preprocess "${circuit_args[@]}" "${preprocessed_args[@]}" \
+                --assignment-table="${circuit_dir}/assignment.tbl" \
+                --assignment-description-file="${run_dir}/assignment_description.dat" &&
+            run_stage estimate "${circuit_args[@]}" \
+                --assignment-description-file="${run_dir}/assignment_description.dat" \
+                --estimate-out="${run_dir}/resource_estimate.json" &&
+            run_stage prove "${circuit_args[@]}" "${preprocessed_args[@]}" \
+                --assignment-table="${circuit_dir}/assignment.tbl" \
+                --proof="${run_dir}/proof.bin" --json="${run_dir}/proof.json" &&
+            run_stage verify "${circuit_args[@]}" "${preprocessed_args[@]}" \
+                --assignment-description-file="${run_dir}/assignment_description.dat" \
+                --proof="${run_dir}/proof.bin"
+        done
+    done
+done
+
+echo "Summary written to ${summary_file}"
+exit $exit_code
@@ -0,0 +1,116 @@
+#!/bin/bash
+
+# Fits the cost model of the 'estimate' stage to the runs of tests/benchmark_stages.sh of one executable and
+# hash type. Every quantity is fitted as a least squares line over the feature the estimate reports for it.
+# Prints the model in the format read by --cost-model.
+
+get_script_dir() {
+    echo "$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+}
+
+parse_args() {
+    benchmark_dir="${script_dir}/../build/benchmark"
+    executable="multi-threaded"
+    hash="keccak"
+
+    while [ "$#" -gt 0 ]; do
+        case "$1" in
+            --benchmark-dir)
+                benchmark_dir="$2"
+                shift 2
+                ;;
+            --executable)
+                executable="$2"
+                shift 2
+                ;;
+            --hash)
+                hash="$2"
+                shift 2
+                ;;
+            *)
+                echo "Unknown argument $1" >&2
+                exit 1
+                ;;
+        esac
+    done
+}
+
+# Prints the first value of a key of a JSON file written by the producer: the top level one of a metrics file,
+# the "features" one of an estimate. Relies on every value being written on its own line.
+json_value() {
+    local file=$1
+    local key=$2
+    awk -v key="$key" '
+        $0 ~ "^ *\"" key "\": " {
+            value = $0
+            sub(".*\": ", "", value)
+            sub(",$", "", value)
+            print value
+            exit
+        }' "$file"
+}
+
+file_size() {
+    stat -c %s "$1"
+}
+
+# Prints "<quantity> <feature> <measured>" for every quantity of a benchmark run.
+run_points() {
+    local run_dir=$1
+    local estimate="${run_dir}/resource_estimate.json"
+    for stage in preprocess prove verify; do
+        echo "${stage}_cpu_seconds $(json_value "$estimate" "${stage}_cpu_seconds")" \
+            "$(json_value "${run_dir}/${stage}.json" cpu_seconds)"
+        echo "${stage}_peak_rss_bytes $(json_value "$estimate" "${stage}_peak_rss_bytes")" \
+            "$(json_value "${run_dir}/${stage}.json" peak_rss_bytes)"
+    done
+    local preprocessed_size=$(( $(file_size "${run_dir}/preprocessed.dat") +
+                                $(file_size "${run_dir}/commitment_state.dat") +
+                                $(file_size "${run_dir}/preprocessed_common_data.dat") ))
+    echo "preprocessed_data_bytes $(json_value "$estimate" preprocessed_data_bytes) ${preprocessed_size}"
+    echo "proof_bytes $(json_value "$estimate" proof_bytes) $(file_size "${run_dir}/proof.bin")"
+}
+
+script_dir=$(get_script_dir)
+parse_args "$@"
+
+runs_amount=0
+points_file=$(mktemp)
+trap 'rm -f "$points_file"' EXIT
+for run_dir in "${benchmark_dir}/${executable}/${hash}"/rows_*; do
+    if [ -f "${run_dir}/resource_estimate.json" ] && [ -f "${run_dir}/verify.json" ] && [ -f "${run_dir}/proof.bin" ]; then
+        run_points "$run_dir" >> "$points_file"
+        runs_amount=$((runs_amount + 1))
+    fi
+done
+if [ "$runs_amount" -eq 0 ]; then
+    echo "No complete ${executable} ${hash} runs in ${benchmark_dir}" >&2
+    exit 1
+fi
+
+echo "# Fitted from ${runs_amount} ${executable} ${hash} runs in ${benchmark_dir}"
+echo "hash_type ${hash}"
+# Lines with a negative slope or intercept, or fitted from a single run, are fitted through the origin instead.
+awk '
+    NF == 3 && $2 > 0 {
+        if (!($1 in n)) {
+            order[++quantities] = $1
+        }
+        n[$1]++; sx[$1] += $2; sy[$1] += $3; sxx[$1] += $2 * $2; sxy[$1] += $2 * $3
+    }
+    END {
+        for (i = 1; i <= quantities; i++) {
+            q = order[i]
+            denominator = n[q] * sxx[q] - sx[q] * sx[q]
+            slope = -1
+            if (n[q] > 1 && denominator > 0) {
+                slope = (n[q] * sxy[q] - sx[q] * sy[q]) / denominator
+                intercept = (sy[q] - slope * sx[q]) / n[q]
+            }
+            if (slope < 0 || intercept < 0) {
+                slope = sxy[q] / sxx[q]
+                intercept = 0
+            }
+            printf "%s %.6g %.6g\n", q, intercept, slope
+        }
+    }' "$points_file"
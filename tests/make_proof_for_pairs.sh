@@ -35,12 +35,48 @@ make_proof_for_pair() {
             color_red "failed"
             return 1
         fi
+
+        echo -n "Proving the indexed $tbl_file by stages: "
+        if prove_by_stages "$tbl_file" "$crct_file" "$proof_dir/stages"; then
+            color_green "success"
+        else
+            color_red "failed"
+            return 1
+        fi
     else
         color_red "${crct_file} file not found for $tbl_file"
         return 1
     fi
 }
 
+# Converts the table to the indexed format, preprocesses it with compressed outputs, proves it read from a pipe
+# into a binary proof and verifies the proof.
+prove_by_stages() {
+    local tbl_file=$1
+    local crct_file=$2
+    local stages_dir=$3
+    mkdir -p "$stages_dir"
+
+    $proof_generator_binary --stage="convert-table" -t "$tbl_file" \
+        --indexed-assignment-table="${stages_dir}/assignment.itbl" ${args_to_forward[@]} &&
+    $proof_generator_binary --stage="preprocess" --circuit "$crct_file" -t "${stages_dir}/assignment.itbl" \
+        --common-data="${stages_dir}/preprocessed_common_data.dat" \
+        --preprocessed-data="${stages_dir}/preprocessed.dat" \
+        --commitment-state-file="${stages_dir}/commitment_state.dat" \
+        --assignment-description-file="${stages_dir}/assignment-description.dat" \
+        --compression-level=3 ${args_to_forward[@]} &&
+    $proof_generator_binary --stage="prove" --circuit "$crct_file" --assignment-table=- \
+        --common-data="${stages_dir}/preprocessed_common_data.dat" \
+        --preprocessed-data="${stages_dir}/preprocessed.dat" \
+        --commitment-state-file="${stages_dir}/commitment_state.dat" \
+        --proof="${stages_dir}/proof.bin" --proof-format=binary ${args_to_forward[@]} \
+        < "${stages_dir}/assignment.itbl" &&
+    $proof_generator_binary --stage="verify" --circuit "$crct_file" \
+        --common-data="${stages_dir}/preprocessed_common_data.dat" \
+        --assignment-description-file="${stages_dir}/assignment-description.dat" \
+        --proof="${stages_dir}/proof.bin" --proof-format=binary ${args_to_forward[@]}
+}
+
 clean_up() {
     echo "Cleaning up proof files..."
     find "$output_dir" -name 'proof' -type f -exec rm {} +